@@ -0,0 +1,74 @@
+#include <PaxPro/paraxialSimulation.hpp>
+#include <PaxPro/alternatingDirectionSolver.hpp>
+#include <PaxPro/gaussianBeam.hpp>
+#include <iostream>
+#include <cstdlib>
+
+using namespace std;
+
+/** Sphere with constant material properties, cheap to evaluate such that the memory traffic dominates */
+class SphereSimulation: public ParaxialSimulation
+{
+public:
+  SphereSimulation( double rad ): ParaxialSimulation("adiBandwidth"), radius(rad){};
+  void getXrayMatProp( double x, double y, double z, double &delta, double &beta ) const override
+  {
+    bool inside = x*x + y*y + z*z < radius*radius;
+    delta = inside ? 8.9E-6:0.0;
+    beta = inside ? 7E-7:0.0;
+  }
+private:
+  double radius{0.0};
+};
+
+/** Measures the time and the effective memory bandwidth of the two ADI half steps
+ *  Usage: ./adiBandwidth.out [number of transverse nodes] [number of steps]
+ */
+int main( int argc, char **argv )
+{
+  unsigned int N = 1024;
+  unsigned int Nz = 16;
+  if ( argc > 1 ) N = atoi( argv[1] );
+  if ( argc > 2 ) Nz = atoi( argv[2] );
+
+  double r = 500.0;
+  double xmin = -1.5*r;
+  double xmax = 1.5*r;
+  double dx = (xmax-xmin)/N;
+  double dz = 2.1*r/Nz;
+
+  try
+  {
+    SphereSimulation sim( r );
+    sim.setTransverseDiscretization( xmin, xmax, dx, N );
+    sim.setVerticalDiscretization( xmin, xmax, dx );
+    sim.setLongitudinalDiscretization( -1.05*r, 1.05*r, dz, Nz );
+    sim.setWaveLength( 0.1569 );
+
+    ADI solver;
+    sim.setSolver( solver );
+
+    GaussianBeam beam;
+    beam.setWavelength( 0.1569 );
+    beam.setWaist( 400.0*r );
+    sim.setBoundaryConditions( beam );
+
+    for ( unsigned int i=0;i<Nz;i++ )
+    {
+      sim.step();
+    }
+
+    double tX = solver.getXImplicitTime()/Nz;
+    double tY = solver.getYImplicitTime()/Nz;
+    cout << "Grid: " << N << "x" << N << ", steps: " << Nz << endl;
+    cout << "Half step\tTime (ms)\tBandwidth (GB/s)\n";
+    cout << "x-implicit\t" << 1E3*tX << "\t" << solver.bytesPerXHalfStep()/tX/1E9 << endl;
+    cout << "y-implicit\t" << 1E3*tY << "\t" << solver.bytesPerYHalfStep()/tY/1E9 << endl;
+  }
+  catch ( exception &exc )
+  {
+    cout << exc.what() << endl;
+    return 1;
+  }
+  return 0;
+}
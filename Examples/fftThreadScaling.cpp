@@ -0,0 +1,92 @@
+#include <PaxPro/genericScattering.hpp>
+#include <omp.h>
+#include <iostream>
+#include <cstdlib>
+
+using namespace std;
+
+/** Sphere centered at (0,0,0) */
+class Sphere: public MaterialFunction
+{
+public:
+  Sphere( double rad ): radius(rad){};
+  void getXrayMatProp( double x, double y, double z, double &delta, double &beta ) const override
+  {
+    double rSq = x*x + y*y + z*z;
+    if ( rSq < radius*radius )
+    {
+      delta = 8.9E-6;
+      beta = 7E-7;
+      return;
+    }
+    delta = 0.0;
+    beta = 0.0;
+  }
+private:
+  double radius{0.0};
+};
+
+/** Measures the number of propagation steps per second for an increasing number of threads
+ *  Usage: ./fftThreadScaling.out [number of transverse nodes] [number of steps]
+ */
+int main( int argc, char **argv )
+{
+  unsigned int N = 1024;
+  unsigned int Nz = 128;
+  if ( argc > 1 ) N = atoi( argv[1] );
+  if ( argc > 2 ) Nz = atoi( argv[2] );
+
+  double r = 500.0;
+  double xmin = -1.5*r;
+  double xmax = 1.5*r;
+  double zmin = -1.05*r;
+  double zmax = 1.05*r;
+  Sphere sphere( r );
+
+  unsigned int maxThreads = omp_get_max_threads();
+  double stepsPerSecSingle = 0.0;
+  cout << "Grid: " << N << "x" << N << ", steps: " << Nz << endl;
+  cout << "Threads\tSteps/sec\tSpeedup\n";
+  try
+  {
+    for ( unsigned int nThreads=1;nThreads<=maxThreads;nThreads*=2 )
+    {
+      omp_set_num_threads( nThreads );
+      GenericScattering simulation("threadScaling");
+      simulation.setBeamWaist( 400.0*r );
+      simulation.setMaxScatteringAngle( 0.05 );
+      simulation.xmin = xmin;
+      simulation.xmax = xmax;
+      simulation.ymin = xmin;
+      simulation.ymax = xmax;
+      simulation.zmin = zmin;
+      simulation.zmax = zmax;
+      simulation.dx = (xmax-xmin)/N;
+      simulation.dy = (xmax-xmin)/N;
+      simulation.dz = (zmax-zmin)/Nz;
+      simulation.downSampleX = N;
+      simulation.downSampleY = N;
+      simulation.downSampleZ = Nz;
+      simulation.wavelength = 0.1569;
+      simulation.supressMessages = true;
+      simulation.propagator = GenericScattering::SolverType_t::FFT;
+      simulation.setNumberOfThreads( nThreads );
+      simulation.setMaterial( sphere );
+
+      double start = omp_get_wtime();
+      simulation.solve();
+      double elapsed = omp_get_wtime() - start;
+
+      // Both the reference run and the run with the object are included
+      double stepsPerSec = 2.0*Nz/elapsed;
+      if ( nThreads == 1 ) stepsPerSecSingle = stepsPerSec;
+      cout << nThreads << "\t" << stepsPerSec << "\t" << stepsPerSec/stepsPerSecSingle << endl;
+    }
+  }
+  catch ( exception &exc )
+  {
+    cout << exc.what() << endl;
+    return 1;
+  }
+  return 0;
+}
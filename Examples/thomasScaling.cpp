@@ -0,0 +1,69 @@
+#include <PaxPro/thomasAlgorithm.hpp>
+#include <omp.h>
+#include <iostream>
+#include <cstdlib>
+#include <complex>
+#include <vector>
+
+using namespace std;
+typedef complex<double> cdouble;
+
+/** Fills a diagonally dominant system similar to the one of the Crank-Nicholson scheme */
+void fillSystem( vector<cdouble> &diag, vector<cdouble> &subdiag, vector<cdouble> &rhs )
+{
+  for ( unsigned int i=0;i<diag.size();i++ )
+  {
+    diag[i] = cdouble( 1.0, 0.5 + 0.01*(i%7) );
+    rhs[i] = cdouble( 1.0*(i%5), -0.3*(i%4) );
+  }
+  for ( unsigned int i=0;i<subdiag.size();i++ )
+  {
+    subdiag[i] = cdouble( 0.0, -0.25 );
+  }
+}
+
+/** Measures the number of tridiagonal solves per second of the partitioned solver for an increasing number of threads
+ *  The serial Thomas algorithm is used as reference.
+ *  Usage: ./thomasScaling.out [number of nodes] [number of repetitions]
+ */
+int main( int argc, char **argv )
+{
+  unsigned int N = 4000000;
+  unsigned int nRep = 20;
+  if ( argc > 1 ) N = atoi( argv[1] );
+  if ( argc > 2 ) nRep = atoi( argv[2] );
+
+  vector<cdouble> diag(N), subdiag(N-1), rhs(N);
+  ThomasAlgorithm solver;
+
+  // Reference: serial Thomas
+  double elapsed = 0.0;
+  for ( unsigned int rep=0;rep<nRep;rep++ )
+  {
+    fillSystem( diag, subdiag, rhs );
+    double start = omp_get_wtime();
+    solver.solve( &diag[0], &subdiag[0], &rhs[0], N );
+    elapsed += omp_get_wtime() - start;
+  }
+  double solvesPerSecSerial = nRep/elapsed;
+  cout << "Nodes: " << N << ", repetitions: " << nRep << endl;
+  cout << "Serial Thomas: " << solvesPerSecSerial << " solves/sec\n";
+  cout << "Threads\tSolves/sec\tSpeedup\n";
+
+  unsigned int maxThreads = omp_get_max_threads();
+  for ( unsigned int nThreads=1;nThreads<=maxThreads;nThreads*=2 )
+  {
+    omp_set_num_threads( nThreads );
+    elapsed = 0.0;
+    for ( unsigned int rep=0;rep<nRep;rep++ )
+    {
+      fillSystem( diag, subdiag, rhs );
+      double start = omp_get_wtime();
+      solver.solvePartitioned( &diag[0], &subdiag[0], &rhs[0], N );
+      elapsed += omp_get_wtime() - start;
+    }
+    double solvesPerSec = nRep/elapsed;
+    cout << nThreads << "\t" << solvesPerSec << "\t" << solvesPerSec/solvesPerSecSerial << endl;
+  }
+  return 0;
+}
@@ -6,11 +6,6 @@ class ParaxialSimulation;
 
 typedef std::complex<double> cdouble;
 
-enum class ApplyDim_t{ROW,COL};
-
-template<ApplyDim_t dim>
-class DimGetter;
-
 /**
 * Transverse absobing function for FFT-based propagation. Can be used to suppress periodic boundary conditions
 * at the cost of reflections from the boundary.
@@ -26,31 +21,13 @@ public:
   /** Sets the inverse damping length in inverse pixels */
   void setInverseDampingLength( double newDamping ){ inverseDampingLength = newDamping; };
 
-  /** Applies the exponential absorber in both ends of the signal */
-  template<ApplyDim_t dim>
-  void apply( arma::cx_mat &field, DimGetter<dim> &getter ) const;
+  /** Returns true if the absorber modifies the signal */
+  bool isActive() const { return thickness > 0; };
+
+  /** Fills prof with the logarithm of the damping factor of a signal of the given length */
+  void exponentProfile( unsigned int length, arma::vec &prof ) const;
 private:
   double inverseDampingLength{0.0};
   unsigned int thickness{0};
 };
-
-/** Getter method for rows or cols. Default returns element mat(i,fixed)*/
-template<ApplyDim_t dim>
-class DimGetter
-{
-public:
-  cdouble& operator()( unsigned int i, arma::cx_mat &mat){ return mat(i,fixed); };
-  unsigned int fixed{0};
-  unsigned int size( arma::cx_mat &mat ){ return mat.n_rows; };
-};
-
-/** Getter method that returns element mat(fixe,i)*/
-template <>
-class DimGetter<ApplyDim_t::ROW>
-{
-public:
-  cdouble& operator()( unsigned int i, arma::cx_mat &mat ){ return mat(fixed,i); };
-  unsigned int fixed{0};
-  unsigned int size( arma::cx_mat &mat ){ return mat.n_cols; };
-};
 #endif
@@ -2,6 +2,7 @@
 #define ALTERNATING_DIRECTION_SOLVER_H
 #include "solver3D.hpp"
 #include "thomasAlgorithm.hpp"
+#include "workspace.hpp"
 #include <complex>
 
 typedef std::complex<double> cdouble;
@@ -17,14 +18,37 @@ class ADI: public Solver3D
 public:
   ADI(): Solver3D("ADI"){};
 
+  /** Set the simulation routine. Allocates the workspace */
+  virtual void setSimulator( ParaxialSimulation &sim ) override;
+
   /** Solves one step */
   virtual void solveStep( unsigned int step ) override;
 
   /** If true transparent boundary conditions will be used, otherwise Dirichlet boundary conditions are used*/
   bool useTBC{true};
+
+  /** Accumulated wall time in seconds spent in the half steps with x and y implicit */
+  double getXImplicitTime() const { return xImplicitTime; };
+  double getYImplicitTime() const { return yImplicitTime; };
+
+  /** Number of bytes streamed through memory in the half steps, used to estimate the bandwidth */
+  double bytesPerXHalfStep() const;
+  double bytesPerYHalfStep() const;
 private:
   ThomasAlgorithm matrixSolver;
 
+  /** Holds the diagonal, subdiagonal and right hand side of the half steps and the transposed field */
+  Workspace workspace;
+
+  double xImplicitTime{0.0};
+  double yImplicitTime{0.0};
+
+  /** Cache blocked transpose of the column major nRows x nCols matrix src into dest */
+  static void blockedTranspose( const cdouble src[], unsigned int nRows, unsigned int nCols, cdouble dest[] );
+
+  /** Number of bytes needed in the workspace */
+  std::size_t workspaceBytes() const;
+
   /** Propagates 1 step by solving x-direction implicitly */
   void xImplicit( unsigned int step );
 
@@ -0,0 +1,85 @@
+#ifndef BATCHED_CRANK_NICHOLSON_H
+#define BATCHED_CRANK_NICHOLSON_H
+#include <armadillo>
+#include <complex>
+#include <string>
+#include <vector>
+#include "thomasAlgorithm.hpp"
+#include "workspace.hpp"
+
+class ParaxialSimulation;
+class ParaxialSource;
+
+typedef std::complex<double> cdouble;
+
+/**
+* Crank-Nicholson solver that advances several 2D simulations on the same grid in lock-step.
+* In each step the systems of all members are assembled and solved with one batched tridiagonal solve.
+* Intended for parameter sweeps, e.g. over the radius of curvature, the width or the wavelength of a waveguide.
+* Only the Cartesian paraxial equation (F = G = H = 1, J = 0) is supported, simulations with other equations are rejected
+*/
+class BatchedCrankNicholson
+{
+public:
+  BatchedCrankNicholson(){};
+  BatchedCrankNicholson( const BatchedCrankNicholson &other ) = delete;
+  BatchedCrankNicholson& operator=( const BatchedCrankNicholson &other ) = delete;
+
+  /**
+  * Add a simulation to the batch. The discretization is taken from the first simulation and the others must match.
+  * The wavenumber and the incident field are taken from the simulation, so the solver and the boundary conditions
+  * must be set. sweepValue is the value of the swept parameter stored in the HDF5 file
+  */
+  void addSimulation( const ParaxialSimulation &sim, double sweepValue );
+
+  /** Use transparent boundary conditions. Dirichlet boundary conditions are default, as in CrankNicholson */
+  void useTransparentBC( bool useTBC ){ transparentBC = useTBC; };
+
+  /** Name of the swept parameter, stored as an attribute in the HDF5 file */
+  void setSweepParameterName( const std::string &name ){ sweepName = name; };
+
+  /** Returns the number of simulations in the batch */
+  unsigned int size() const { return members.size(); };
+
+  /** Solve all simulations */
+  void solve();
+
+  /** Returns the solution of member m. Every downsamplingRatio longitudinal plane is stored */
+  const arma::cx_mat& getSolution( unsigned int m ) const { return solutions[m]; };
+
+  /** Saves the amplitude and phase of all members to one HDF5 file. The first dimension is the sweep */
+  void save( const std::string &fname ) const;
+private:
+  struct Member
+  {
+    const ParaxialSimulation *sim{nullptr};
+    double sweepValue{0.0};
+  };
+
+  std::vector<Member> members;
+  std::vector<arma::cx_mat> solutions;
+  std::string sweepName{"sweep"};
+  bool transparentBC{false};
+  ThomasAlgorithm matrixSolver;
+  Workspace workspace;
+
+  unsigned int Nx{0};
+  unsigned int Nz{0};
+  unsigned int storeEvery{1};
+
+  /** Fields of all members, member m is stored at m*Nx */
+  arma::cx_vec prevField;
+
+  /** Material properties of all members in the previous and current plane */
+  arma::vec deltaPrev, betaPrev, delta, beta;
+
+  /** Evaluates the material properties of all members in the plane z */
+  void evaluatePlane( double z, arma::vec &deltaPlane, arma::vec &betaPlane ) const;
+
+  /** Applies the transparent boundary condition of member m on one side */
+  void applyTBCOneSide( unsigned int m, cdouble diag[], cdouble rhs[], unsigned int outer, unsigned int inner, double rho ) const;
+
+  /** Checks that the simulation has the same grid as the first member */
+  void verifyGrid( const ParaxialSimulation &sim ) const;
+};
+#endif
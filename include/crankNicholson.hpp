@@ -2,6 +2,7 @@
 #define CRANC_NICHOLSON_H
 #include "solver2D.hpp"
 #include "thomasAlgorithm.hpp"
+#include "workspace.hpp"
 #include <complex>
 
 template<class T>
@@ -19,13 +20,56 @@ public:
   CrankNicholson():Solver2D("CrankNicholson"){};
   ~CrankNicholson();
 
+  /** Set the simulator. Allocates the workspace */
+  virtual void setSimulator( ParaxialSimulation &newGuide ) override;
+
   /** Solves single step */
   virtual void solveStep( unsigned int iz ) override final;
 protected:
   ThomasAlgorithm matrixSolver;
 
+  /** Holds the tridiagonal system */
+  Workspace workspace;
+
+  /** Number of bytes needed in the workspace for Nx nodes */
+  static std::size_t workspaceBytes( unsigned int nNodes );
+
   /** Parameters used internally, but needs to be shared between member functions */
-  double Hpluss, Hminus, gval, HplussPrev, HminusPrev, gvalPrev, rho;
+  double rho;
+
+  /** Systems with fewer nodes are assembled by one thread, as the threading overhead would dominate */
+  static const unsigned int MIN_NODES_PARALLEL_ASSEMBLY = 4096;
+
+  /** Coefficients of the equation and material properties in one plane. J is included in delta */
+  struct CoefficientPlane
+  {
+    arma::vec delta;
+    arma::vec beta;
+    arma::vec F;
+    arma::vec G;
+    arma::vec Hpluss;
+    arma::vec Hminus;
+    double z{0.0};
+    bool isValid{false};
+  };
+
+  /** The current plane of one step is reused as the previous plane in the next */
+  CoefficientPlane planes[2];
+  CoefficientPlane *prevPlane{&planes[0]};
+  CoefficientPlane *currentPlane{&planes[1]};
+
+  /** Evaluates the coefficients in the plane z. Selects the equation policy from the type of the equation */
+  void evaluatePlane( double z, CoefficientPlane &plane ) const;
+
+  /** Fills the plane with the coefficients of the equation policy Eq and the material properties */
+  template<class Eq>
+  void fillPlane( const Eq &equation, double z, CoefficientPlane &plane ) const;
+
+  /** Updates the previous and current plane for a step ending at z */
+  void updatePlanes( double z, bool firstStep );
+
+  /** Returns true if neither the equation nor the material depend on z */
+  bool coefficientsAreZIndependent() const;
 
   bool printBC{true};
 
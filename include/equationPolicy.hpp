@@ -0,0 +1,43 @@
+#ifndef EQUATION_POLICY_H
+#define EQUATION_POLICY_H
+#include "paraxialEquation.hpp"
+
+/**
+* Compile time versions of ParaxialEquation. The solvers are templated on these,
+* such that the coefficients of the common equations are inlined instead of being
+* evaluated through virtual calls
+*/
+namespace eqpolicy
+{
+/** Cartesian coordinates F = G = H = 1 and J = 0 */
+struct Cartesian
+{
+  double F( double x, double z ) const { return 1.0; };
+  double G( double x, double z ) const { return 1.0; };
+  double H( double x, double z ) const { return 1.0; };
+  double J( double x, double z ) const { return 0.0; };
+};
+
+/** Conformal transformation of a bent waveguide, same as ConformalEquation */
+struct Conformal
+{
+  Conformal( double radiusOfCurvature ): invR(1.0/radiusOfCurvature){};
+  double F( double x, double z ) const { return 1.0; };
+  double G( double x, double z ) const { return 1.0; };
+  double H( double x, double z ) const { return 1.0; };
+  double J( double x, double z ) const { return x*invR; };
+  double invR{0.0};
+};
+
+/** Forwards to a user defined equation through virtual calls */
+struct Virtual
+{
+  Virtual( const ParaxialEquation &equation ): eq(&equation){};
+  double F( double x, double z ) const { return eq->F(x,z); };
+  double G( double x, double z ) const { return eq->G(x,z); };
+  double H( double x, double z ) const { return eq->H(x,z); };
+  double J( double x, double z ) const { return eq->J(x,z); };
+  const ParaxialEquation *eq{nullptr};
+};
+};
+#endif
@@ -0,0 +1,133 @@
+#ifndef FFT_PLAN_MANAGER_H
+#define FFT_PLAN_MANAGER_H
+#include <fftw3.h>
+#include <complex>
+#include <string>
+#include <vector>
+
+typedef std::complex<double> cdouble;
+typedef std::complex<float> cfloat;
+
+/** Rigor used by FFTW when a plan is created */
+enum class PlanRigor_t {ESTIMATE, MEASURE, PATIENT};
+
+/**
+* Class that creates and keeps FFTW plans. The plans are created on scratch arrays
+* (so measuring does not overwrite any data) and executed via the new-array interface of FFTW.
+* Hence, the plans remains valid when the arrays they operate on are reallocated,
+* and they are only destroyed when the manager is destroyed or cleared.
+*/
+class FFTPlanManager
+{
+public:
+  FFTPlanManager(){};
+  FFTPlanManager( const FFTPlanManager &other ) = delete;
+  FFTPlanManager& operator =( const FFTPlanManager &other ) = delete;
+  ~FFTPlanManager();
+
+  /** Set the rigor used when new plans are created. Existing plans are destroyed if the rigor changes */
+  void setRigor( PlanRigor_t newRigor );
+
+  /** Get the rigor used when creating plans */
+  PlanRigor_t getRigor() const { return rigor; };
+
+  /** Set the number of threads FFTW uses in new plans. If 0, the maximum number of OpenMP threads is used */
+  void setNumberOfThreads( unsigned int nThreads ){ numberOfThreads = nThreads; };
+
+  /** Returns the number of threads that will be used in new plans */
+  unsigned int getNumberOfThreads() const;
+
+  /** 1D transform of an array of length N. If in == out the transform is in-place */
+  void execute1D( cdouble *in, cdouble *out, unsigned int N, int sign );
+
+  /** In-place transform of howmany consecutive arrays of length N (the columns of a matrix) */
+  void executeMany1D( cdouble *data, unsigned int N, unsigned int howmany, int sign );
+
+  /** 2D transform of a matrix stored in column major order (Armadillo layout). If in == out the transform is in-place */
+  void execute2D( cdouble *in, cdouble *out, unsigned int nrows, unsigned int ncols, int sign );
+
+  /** Single precision versions of the transforms above */
+  void execute1D( cfloat *in, cfloat *out, unsigned int N, int sign );
+  void executeMany1D( cfloat *data, unsigned int N, unsigned int howmany, int sign );
+  void execute2D( cfloat *in, cfloat *out, unsigned int nrows, unsigned int ncols, int sign );
+
+  /** Destroys all plans */
+  void clear();
+
+  /** Returns the number of plans currently stored */
+  unsigned int numberOfPlans() const { return plans.size(); };
+
+  /**
+  * Load FFTW wisdom from file. The single precision wisdom in fname.single is only imported when the
+  * first single precision plan is created. Returns true if the double precision wisdom was imported
+  */
+  static bool loadWisdom( const std::string &fname );
+
+  /**
+  * Save the accumulated FFTW wisdom to file. The single precision wisdom is written to fname.single
+  * if any single precision plans have been created. Returns true on success
+  */
+  static bool saveWisdom( const std::string &fname );
+
+  /** Returns the name of the file holding the single precision wisdom */
+  static std::string singlePrecisionWisdomFile( const std::string &fname );
+private:
+  /** Parameters that uniquely identifies a plan */
+  struct PlanKey
+  {
+    int rank{1};
+    int n0{0};
+    int n1{1};
+    int howmany{1};
+    int sign{FFTW_FORWARD};
+    int nThreads{1};
+    bool inPlace{false};
+    bool unaligned{false};
+    bool singlePrecision{false};
+  };
+
+  /** Only the plan matching the precision of the key is created */
+  struct StoredPlan
+  {
+    PlanKey key;
+    fftw_plan plan{NULL};
+    fftwf_plan planf{NULL};
+  };
+
+  PlanRigor_t rigor{PlanRigor_t::ESTIMATE};
+  unsigned int numberOfThreads{0};
+  std::vector<StoredPlan> plans;
+
+  /** Single precision wisdom file that is imported before the next single precision plan is created */
+  static std::string pendingSingleWisdomFile;
+
+  /** True if any manager has created a single precision plan */
+  static bool singlePlansCreated;
+
+  /** Initialize the threaded version of FFTW. Only the first call has any effect */
+  static void initThreads();
+
+  /** Returns a stored plan matching the key. A new plan is created if no such plan exists */
+  const StoredPlan& getPlan( const PlanKey &key );
+
+  /** Creates a new plan on scratch arrays. Returns NULL on failure. The caller holds the planner lock */
+  fftw_plan createPlan( const PlanKey &key ) const;
+
+  /** Creates a new single precision plan on scratch arrays. Returns NULL on failure. The caller holds the planner lock */
+  fftwf_plan createPlanSingle( const PlanKey &key ) const;
+
+  /** Imports the pending single precision wisdom. The caller holds the planner lock */
+  static void importPendingSingleWisdom();
+
+  /** Execute the transform corresponding to key */
+  void execute( PlanKey &key, cdouble *in, cdouble *out );
+  void execute( PlanKey &key, cfloat *in, cfloat *out );
+
+  /** Fills the key of a 1D, batched 1D or 2D transform */
+  static PlanKey key1D( unsigned int N, unsigned int howmany, int sign );
+  static PlanKey key2D( unsigned int nrows, unsigned int ncols, int sign );
+
+  /** Returns the FFTW planner flag corresponding to the rigor */
+  unsigned int rigorFlag() const;
+};
+#endif
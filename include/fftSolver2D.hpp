@@ -3,6 +3,7 @@
 #include "solver2D.hpp"
 #include <fftw3.h>
 #include <complex>
+#include "fftPlanManager.hpp"
 
 typedef std::complex<double> cdouble;
 
@@ -18,25 +19,82 @@ public:
 
   /** Propagate the beam one step */
   void solveStep( unsigned int step ) override;
+
+  /** Set the rigor used when FFTW creates plans */
+  void setPlanRigor( PlanRigor_t rigor ){ plans.setRigor( rigor ); };
+
+  /** Set the number of threads used by FFTW */
+  virtual void setNumberOfThreads( unsigned int nThreads ) override;
+
+  /**
+  * Enable/disable vacuum skipping. In runs of slices without material the spectrum at the start
+  * of the run is propagated directly to each plane, requiring only one inverse FFT per step
+  */
+  void setVacuumSkipping( bool enable ){ vacuumSkipping = enable; };
+
+  /** Set the operator splitting. STRANG applies half the refraction before and after the diffraction */
+  void setSplitting( Splitting_t newSplitting ){ splitting = newSplitting; };
+
+  /** Set the precision used internally. In single precision the FFTs and the refraction are done in float arrays */
+  void setPrecision( Precision_t newPrecision ){ precision = newPrecision; };
+
+  /** Resets the solver */
+  virtual void reset() override;
 protected:
   unsigned int initialLength{0};
 
+  /** Lie splitting is first order, Strang splitting is second order */
+  virtual unsigned int orderOfAccuracy() const override;
+
   /** Kernel function */
   cdouble kernel( double kx ) const;
 
-  /** Propagate an FFT step */
-  void propagate();
+  /** Advances field one step and stores the result in out. The content of field is destroyed */
+  template<class T>
+  void advance( bool isVacuum, arma::Col< std::complex<T> > &field, arma::Col< std::complex<T> > &out,
+                arma::Col< std::complex<T> > &spectrum );
+
+  /** Propagate an FFT step. work is used as scratch array */
+  template<class T>
+  void propagate( arma::Col< std::complex<T> > &field, arma::Col< std::complex<T> > &work );
 
   /** Perform the refraction step */
-  void refraction( unsigned int step );
+  template<class T>
+  void refraction( const arma::Col< std::complex<T> > &field, arma::Col< std::complex<T> > &out );
+
+  /** Evaluates the material properties at the refraction plane. Returns true if the plane is vacuum */
+  bool evaluateMaterial( unsigned int step );
+
+  /** Propagates the spectrum at the start of the current vacuum gap to the next plane */
+  template<class T>
+  void vacuumStep( arma::Col< std::complex<T> > &field, arma::Col< std::complex<T> > &spectrum, arma::Col< std::complex<T> > &out );
+
+  /** Symmetric split step: half refraction, diffraction, half refraction */
+  template<class T>
+  void strangStep( arma::Col< std::complex<T> > &field, arma::Col< std::complex<T> > &out );
 
   /** Return the spatial frequency corresponding to indx */
   double spatialFreq( unsigned int indx, unsigned int size ) const;
 
-  fftw_plan ftforw;
-  fftw_plan ftback;
-  fftw_complex *prev{NULL};
-  fftw_complex *curr{NULL};
-  bool planInitialized{false};
+  FFTPlanManager plans;
+
+  /** Material properties at the refraction plane */
+  arma::vec deltaSlice;
+  arma::vec betaSlice;
+
+  /** Spectrum at the start of the current vacuum gap and the distance propagated since */
+  bool vacuumSkipping{true};
+  bool gapIsOpen{false};
+  double gapDistance{0.0};
+  arma::cx_vec gapSpectrum;
+
+  Splitting_t splitting{Splitting_t::LIE};
+  arma::cx_vec halfTransmission;
+
+  /** Single precision arrays */
+  Precision_t precision{Precision_t::DOUBLE};
+  arma::cx_fvec fieldSingle;
+  arma::cx_fvec workSingle;
+  arma::cx_fvec gapSpectrumSingle;
 };
 #endif
@@ -6,6 +6,7 @@
 #include <visa/visa.hpp>
 #include <string>
 #include "absorber.hpp"
+#include "fftPlanManager.hpp"
 
 typedef std::complex<double> cdouble;
 
@@ -22,6 +23,9 @@ public:
   /** Propgate one step */
   void solveStep( unsigned int step );
 
+  /** Propagate one step. In single precision the field is only copied to the double arrays at the stored planes */
+  virtual void step() override;
+
   /** A call to this before solving will visualize the real space intensity on each iteration */
   void visualizeRealSpace();
 
@@ -43,7 +47,33 @@ public:
   /** Set absorbing boundary conditions */
   void absorbingBC( double width, double dampingLength );
 
-  /** Resets the solver */
+  /** Set the rigor used when FFTW creates plans */
+  void setPlanRigor( PlanRigor_t rigor ){ plans.setRigor( rigor ); };
+
+  /** Set the number of threads used by FFTW */
+  virtual void setNumberOfThreads( unsigned int nThreads ) override;
+
+  /**
+  * Enable/disable vacuum skipping. Runs of slices without material are crossed with a single
+  * combined propagation kernel. The field is still propagated to all stored planes.
+  * Skipping is never used when an absorber or real space visualization is active
+  */
+  void setVacuumSkipping( bool enable ){ vacuumSkipping = enable; };
+
+  /**
+  * Set the operator splitting. With STRANG the second half refraction of one step is fused with
+  * the first half of the next, and is only completed at the stored planes
+  */
+  void setSplitting( Splitting_t newSplitting ){ splitting = newSplitting; };
+
+  /**
+  * Set the precision used internally. In single precision the field is propagated in float arrays
+  * with single precision FFTW plans, and converted to double precision at the stored planes.
+  * The real space visualization is only updated at the stored planes
+  */
+  void setPrecision( Precision_t newPrecision );
+
+  /** Resets the solver. NOTE: The FFTW plans are kept */
   virtual void reset() override;
 private:
   /** The convolution kernel */
@@ -55,17 +85,25 @@ private:
   /** Return the spatial frequency corresponding to indx in the y-direction */
   double spatialFreqY( unsigned int indx, unsigned int size ) const;
 
-  /** Performs absorbing boundary conditions */
-  void applyAbsorbingBC();
+  /** Tabulates the absorber profiles if they do not match the current grid */
+  void updateAbsorberProfiles();
+
+  /** Returns the logarithm of the absorber damping factor at pixel i */
+  double absorberExponent( unsigned int i ) const;
+
+  /** Returns true if the tabulated kernel does not match the current discretization and wavenumber */
+  bool kernelIsOutdated() const;
+
+  /** Tabulates the propagation kernel including the FFTW normalization */
+  void computeKernel();
+
+  /** Returns true if runs of vacuum slices can be crossed in one step */
+  bool canSkipVacuum() const;
 
   double intensityMin{0.0};
   double intensityMax{1.1};
 
-  fftw_complex *curr{NULL};
-  fftw_complex *prev{NULL};
-  fftw_plan ftforw;
-  fftw_plan ftback;
-  bool planInitialized{false};
+  FFTPlanManager plans;
   bool overlayRefractiveIndex{false};
   bool createAnimation{false};
   std::string imageName{""};
@@ -73,14 +111,87 @@ private:
   Absorber absorbX;
   Absorber absorbY;
 
-  /** Diffraction step */
-  void propagate();
+  /**
+  * Separable absorber stored as the logarithm of the damping in each direction.
+  * It is added to the refraction exponent, so no separate pass over the field is needed
+  */
+  arma::vec absorberExponentX;
+  arma::vec absorberExponentY;
+  bool absorberIsActive{false};
+
+  /** Tabulated kernel and the parameters used to compute it */
+  arma::cx_mat kernelTable;
+  double kernelStepX{0.0};
+  double kernelStepY{0.0};
+  double kernelStepZ{0.0};
+  double kernelWavenumber{0.0};
+
+  /** Squared transverse spatial frequency used to build kernels for arbitrary distances */
+  arma::mat kSqTable;
+
+  /** Single precision field, work array and kernel */
+  Precision_t precision{Precision_t::DOUBLE};
+  arma::cx_fmat fieldSingle;
+  arma::cx_fmat workSingle;
+  arma::cx_fmat kernelTableSingle;
+  arma::cx_fmat pendingHalfRefractionSingle;
+
+  /** Material properties in the previous and current plane. The buffers are swapped after each step */
+  arma::mat deltaPrevSlice;
+  arma::mat betaPrevSlice;
+  arma::mat deltaSlice;
+  arma::mat betaSlice;
+  bool prevSliceIsValid{false};
+  bool prevSliceIsVacuum{false};
+  bool sliceIsVacuum{false};
+  unsigned int prevSliceStep{0};
+
+  /** Propagation distance that has been skipped since the last diffraction step */
+  bool vacuumSkipping{true};
+  double pendingDistance{0.0};
+
+  /** Second half of the refraction in the previous step that has not been applied yet */
+  Splitting_t splitting{Splitting_t::LIE};
+  arma::cx_mat pendingHalfRefraction;
+  bool halfRefractionPending{false};
+
+  /** Advances field from step-1 to step. work is used as scratch array */
+  template<class T>
+  void advance( unsigned int step, bool isStored, arma::Mat< std::complex<T> > &field, arma::Mat< std::complex<T> > &work,
+                const arma::Mat< std::complex<T> > &kernelTab, arma::Mat< std::complex<T> > &pendingHalf );
+
+  /** Diffraction step of field over the distance dz */
+  template<class T>
+  void propagate( arma::Mat< std::complex<T> > &field, arma::Mat< std::complex<T> > &work,
+                  const arma::Mat< std::complex<T> > &kernelTab, double dz );
+
+  /** Updates the material slices for the given step */
+  void updateMaterialSlices( unsigned int step );
 
   /** Refraction step */
-  void refraction( unsigned int step );
+  template<class T>
+  void refraction( arma::Mat< std::complex<T> > &field, unsigned int step );
+
+  /** Symmetric split step: half refraction, diffraction, half refraction */
+  template<class T>
+  void strangStep( unsigned int step, bool isStored, arma::Mat< std::complex<T> > &field, arma::Mat< std::complex<T> > &work,
+                   const arma::Mat< std::complex<T> > &kernelTab, arma::Mat< std::complex<T> > &pendingHalf );
+
+  /** Returns the exponent of the transmission function of pixel i between z0 and z1 */
+  cdouble refractionExponent( unsigned int i, double z0, double z1 );
+
+  /** Updates the real space visualization with the field at z */
+  void updateVisualization( const arma::cx_mat &field, double z );
+
+  /**
+  * Computes the refraction integral when a border has been crossed.
+  * delta1 and beta1 are the values at z1. On input delta and beta are the values at z2,
+  * on output they hold the averaged values
+  */
+  void refractionIntegral( double x, double y, double z1, double z2, double delta1, double beta1, double &delta, double &beta );
 
-  /** Computes the refraction integral when a border has been crossed */
-  void refractionIntegral( double x, double y, double z1, double z2, double &delta, double &beta );
+  /** Evaluates the material properties in the plane z into the given buffers. Returns true if the plane is vacuum */
+  bool evaluateMaterialSlice( double z, arma::mat &delta, arma::mat &beta ) const;
 
   /** Evaluates the refractive index for the purpose of overlay */
   void evaluateRefractiveIndex( arma::mat &refr, double z ) const;
@@ -11,7 +11,7 @@ public:
   /** Evaluate the beam at position x, z. Both in nano meters */
   cdouble get( double x, double z ) const override final;
 
-  /** Gaussian beam in 3D */
+  /** Gaussian beam in 3D with a circular cross section, including the wavefront curvature in both directions */
   cdouble get( double x, double y, double z ) const override final;
 
   /** Sets the waist in nano meter */
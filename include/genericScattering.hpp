@@ -7,11 +7,25 @@
 #include "materialFunction.hpp"
 #include "alternatingDirectionSolver.hpp"
 #include "projectionSolver.hpp"
+#include "hankelSolver3D.hpp"
+
+/** Pose of the sample in one point of a scan. The rotation is applied before the translation */
+struct ScanPoint
+{
+  double angleDeg{0.0};
+  geom::Axis_t axis{geom::Axis_t::Y};
+  double x{0.0};
+  double y{0.0};
+  double z{0.0};
+};
 
 class GenericScattering: public ParaxialSimulation
 {
 public:
-  enum class SolverType_t {ADI,FFT,PROJ};
+  enum class SolverType_t {ADI,FFT,PROJ,HANKEL};
+
+  /** How the vacuum reference subtracted from the exit field before computing the far field is obtained */
+  enum class Reference_t {PROPAGATE,ANALYTIC,CACHED};
   GenericScattering( const char* name );
   virtual ~GenericScattering();
 
@@ -26,9 +40,23 @@ public:
   /** Solve scattering */
   virtual void solve() override;
 
+  /**
+  * Solves the scattering for each pose of the sample, relative to its current orientation which is restored afterwards.
+  * The sample has to be a module of the material. The solver arrays, FFT plans and the reference are set up once.
+  * The 2D results of the post processing modules (exit field, far field etc.) of all points are written to one
+  * HDF5 file, with the scan point as the first dimension
+  */
+  void scan( geom::Module &sample, const std::vector<ScanPoint> &points, const char* fname );
+
   /** Gets the X-ray material properties */
   virtual void getXrayMatProp( double x, double y, double z, double &delta, double &beta ) const override;
 
+  /** Returns true if the material supports analytic line integrals */
+  virtual bool hasAnalyticProjection() const override;
+
+  /** Gets the line integrals of the X-ray material properties */
+  virtual void getProjectedXrayMatProp( double x, double y, double zmin, double zmax, double &deltaInt, double &betaInt ) const override;
+
   /** Prints all the attributes */
   void printInfo() const;
 
@@ -64,6 +92,31 @@ public:
   bool realTimeVisualization{false};
   SolverType_t propagator{SolverType_t::FFT};
   bool supressMessages{false};
+
+  /** Rigor used when FFTW creates plans. MEASURE and PATIENT gives faster transforms, but planning takes longer */
+  PlanRigor_t fftPlanRigor{PlanRigor_t::ESTIMATE};
+
+  /** Operator splitting used by the FFT solver. STRANG is second order in dz */
+  Splitting_t fftSplitting{Splitting_t::LIE};
+
+  /** If true, the FFT solver crosses vacuum gaps with one diffraction step */
+  bool fftVacuumSkipping{true};
+
+  /** Precision used internally by the FFT and projection solvers. SINGLE halves the memory traffic */
+  Precision_t fftPrecision{Precision_t::DOUBLE};
+
+  /** If true, the projection solver integrates CSG materials analytically along each ray instead of slice by slice */
+  bool analyticProjection{false};
+
+  /**
+  * PROPAGATE runs the solver without material before each simulation, keeping only the last plane.
+  * ANALYTIC evaluates the Gaussian beam in free space at the exit plane and skips the extra run.
+  * CACHED propagates once and reuses the result as long as the grid, the beam and the solver settings are unchanged
+  */
+  Reference_t referenceMode{Reference_t::PROPAGATE};
+
+  /** If given, FFTW wisdom is loaded from this file before solving and stored to it afterwards. Single precision wisdom uses fftwWisdomFile.single */
+  std::string fftwWisdomFile{""};
 private:
   const MaterialFunction *material{NULL};
   post::ExitField ef;
@@ -76,10 +129,38 @@ private:
   FFTSolver3D fft3Dsolver;
   ADI adisolver;
   ProjectionSolver projSolver;
+  HankelSolver3D hankelSolver;
 
   arma::cx_mat *reference{NULL};
   bool isReferenceRun{true};
 
+  /** Parameters that determine the reference solution */
+  struct ReferenceKey
+  {
+    double xmin, xmax, ymin, ymax, zmin, zmax, dx, dy, wavelength, waist;
+    unsigned int downSampleX;
+    SolverType_t propagator;
+    Splitting_t splitting;
+    Precision_t precision;
+    bool operator ==( const ReferenceKey &other ) const;
+  };
+  ReferenceKey cachedReferenceKey;
+
+  /** Returns the key corresponding to the current settings */
+  ReferenceKey referenceKey() const;
+
+  /** Returns true if the reference has to be obtained by propagating the beam through vacuum */
+  bool referenceRunIsNeeded() const;
+
+  /** Computes or reuses the reference solution */
+  void computeReference();
+
+  /** Evaluates the Gaussian beam at the exit plane */
+  void analyticReference();
+
+  /** Solves again with the same discretization and reference, after the material has been changed */
+  void solveAgain();
+
   bool isFirstTime{true};
 
   /** Has to be called before simulation is solved */
@@ -7,6 +7,16 @@
 namespace geom
 {
   enum class Operation_t{UNION, DIFFERENCE};
+
+  /** Part of a line parallel to the z-axis with constant material properties */
+  struct ZSegment
+  {
+    double zEnter;
+    double zExit;
+    double delta;
+    double beta;
+  };
+
   class Part
   {
   public:
@@ -35,6 +45,15 @@ namespace geom
     /** Returns true if is inside */
     bool isInside( double x, double y, double z ) const;
 
+    /** Appends the transformation matrices of all shapes */
+    void getTransformations( std::vector<arma::mat> &transformations ) const;
+
+    /** Sets the transformations of all shapes starting at index start. Returns the index after the last one used */
+    unsigned int setTransformations( const std::vector<arma::mat> &transformations, unsigned int start );
+
+    /** Appends the segments of the line through (x,y) parallel to the z-axis that are inside the part */
+    void zSegments( double x, double y, std::vector<ZSegment> &segments ) const;
+
     /** Simply dump all the objects to an openSCAD file  */
     void dump( const char* fname ) const;
 
@@ -82,6 +101,12 @@ namespace geom
     /** Returns the X-ray material properties at position (x,y,z). Return true if the point belongs to the module */
     bool getXrayMatProp( double x, double y, double z, double &delta, double &beta ) const;
 
+    /**
+    * Appends the segments of the line through (x,y) parallel to the z-axis that belong to the module,
+    * in the same sense as getXrayMatProp. Segments removed by a difference have zero delta and beta
+    */
+    void zSegments( double x, double y, std::vector<ZSegment> &segments ) const;
+
     /** Translate the entire module */
     void translate( double x, double y, double z );
 
@@ -91,6 +116,12 @@ namespace geom
     /** Scales an object along axis */
     void scale( double factor, Axis_t axis );
 
+    /** Returns the transformation matrices of all shapes in all parts */
+    void getTransformations( std::vector<arma::mat> &transformations ) const;
+
+    /** Restores transformations obtained with getTransformations */
+    void setTransformations( const std::vector<arma::mat> &transformations );
+
     /** Saves the individual parts to openSCAD files */
     void saveIndividualParts( const char* prefix );
 
@@ -0,0 +1,102 @@
+#ifndef HANKEL_SOLVER_3D_H
+#define HANKEL_SOLVER_3D_H
+#include "solver3D.hpp"
+#include <complex>
+
+typedef std::complex<double> cdouble;
+
+/**
+* Solver for rotationally symmetric problems. The field is represented on a radial grid
+* and the diffraction step is performed with a quasi-discrete Hankel transform.
+* The material is evaluated along the line y = 0, x >= 0.
+* The Cartesian field is only rendered when the stored planes or the last solution are requested.
+* The fields and the material need O(N) memory for N radial nodes, but the transformation matrix of the QDHT
+* is tabulated and needs O(N^2) memory
+*/
+class HankelSolver3D: public Solver3D
+{
+public:
+  HankelSolver3D(): Solver3D("HankelSolver3D"){};
+
+  /** Set the simulation routine */
+  virtual void setSimulator( ParaxialSimulation &sim ) override;
+
+  /** Set the initial conditions. The radial field is sampled along y = 0, x >= 0 */
+  virtual void setInitialConditions( const arma::cx_mat &values ) override;
+
+  /** Propagate one step */
+  virtual void step() override;
+
+  /** Returns the last solution rendered on the Cartesian grid */
+  virtual const arma::cx_mat& getLastSolution3D() const override;
+
+  /** Set the number of radial nodes. If 0, half the number of transverse nodes is used */
+  void setNumberOfRadialNodes( unsigned int N ){ nRadialNodes = N; };
+
+  /** Returns the radial positions of the nodes */
+  const arma::vec& getRadialNodes() const { return rNodes; };
+
+  /** Returns the field at the radial nodes */
+  const arma::cx_vec& getRadialField() const { return radialField; };
+
+  /** Resets the solver */
+  virtual void reset() override;
+protected:
+  /** Propagates the radial field one step */
+  virtual void solveStep( unsigned int step ) override;
+private:
+  unsigned int nRadialNodes{0};
+  double radius{0.0};
+
+  /** Zeros of J0 and |J1| evaluated at the zeros */
+  arma::vec besselZeros;
+  arma::vec besselJ1;
+  arma::vec rNodes;
+
+  /** Symmetric transformation matrix of the QDHT. It is real, so it is applied to the real and imaginary parts separately */
+  arma::mat transform;
+
+  /** Diffraction factors of the transverse wave vectors for one step, tabulated with the parameters used to compute them */
+  arma::cx_vec diffraction;
+  double propStepZ{0.0};
+  double propWavenumber{0.0};
+
+  arma::cx_vec radialField;
+  arma::cx_vec radialWork;
+
+  /** Material properties in the previous and current plane */
+  arma::vec deltaPrev;
+  arma::vec betaPrev;
+  arma::vec delta;
+  arma::vec beta;
+  bool prevSliceIsValid{false};
+  unsigned int nStepsInRefrIntegral{10};
+
+  mutable arma::cx_mat cartesian;
+  mutable bool cartesianIsOutdated{true};
+
+  /** Computes the radial nodes and the Bessel function values */
+  void computeGrid();
+
+  /** Returns true if the propagation operator does not match the current discretization and wavenumber */
+  bool propagatorIsOutdated() const;
+
+  /** Computes the transformation matrix T and the diffraction factors K of the propagation operator T*diag(K)*T */
+  void computePropagator();
+
+  /** Applies the transformation matrix to a complex vector */
+  void applyTransform( const arma::cx_vec &in, arma::cx_vec &out ) const;
+
+  /** Evaluates the material properties at the radial nodes */
+  void evaluateMaterial( double z, arma::vec &deltaRad, arma::vec &betaRad ) const;
+
+  /** Computes the refraction integral at radial node n when a border has been crossed */
+  void refractionIntegral( unsigned int n, double z1, double z2, double &deltaAvg, double &betaAvg ) const;
+
+  /** Linearly interpolates the radial field at r */
+  cdouble interpolate( double r ) const;
+
+  /** Renders the radial field at the Cartesian positions */
+  void render( arma::cx_mat &mat, double rowStep, double colStep ) const;
+};
+#endif
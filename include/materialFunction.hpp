@@ -6,7 +6,15 @@
 class MaterialFunction
 {
 public:
+  virtual ~MaterialFunction(){};
+
   virtual void getXrayMatProp( double x, double y, double z, double &delta, double &beta ) const = 0;
+
+  /** Returns true if the line integrals of the material properties can be computed with getProjectedXrayMatProp */
+  virtual bool hasAnalyticProjection() const { return false; };
+
+  /** Computes the integrals of delta and beta along the line through (x,y) parallel to the z-axis from zmin to zmax */
+  virtual void getProjectedXrayMatProp( double x, double y, double zmin, double zmax, double &deltaInt, double &betaInt ) const;
 };
 
 class CSGMaterial: public MaterialFunction
@@ -16,6 +24,12 @@ public:
 
   virtual void getXrayMatProp( double x, double y, double z, double &delta, double &beta ) const override;
 
+  /** The shapes are intersected analytically with the line */
+  virtual bool hasAnalyticProjection() const override { return true; };
+
+  /** Computes the line integrals from the intersections of the line with the shapes */
+  virtual void getProjectedXrayMatProp( double x, double y, double zmin, double zmax, double &deltaInt, double &betaInt ) const override;
+
   /** Adds a new part */
   void addModule( const geom::Module &newmodule );
 
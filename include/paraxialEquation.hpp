@@ -32,5 +32,32 @@ public:
 
   /** Return phase factor at position z */
   virtual cdouble phaseFactor( double k, double z ) const;
+
+  /**
+  * Return true if F, G, H and J do not depend on z. The default equation is z-independent,
+  * derived classes must override this to allow the coefficients to be tabulated
+  */
+  virtual bool isZIndependent() const;
+};
+
+/**
+* Conformal transformation of a waveguide bent with radius of curvature R
+* into a straight guide. F = G = H = 1 and J = x/R
+*/
+class ConformalEquation final: public ParaxialEquation
+{
+public:
+  ConformalEquation( double radiusOfCurvature ): R(radiusOfCurvature){};
+
+  /** Return the coefficient that is added to the delta */
+  virtual double J( double x, double z ) const override { return x/R; };
+
+  /** The coefficients do not depend on z */
+  virtual bool isZIndependent() const override { return true; };
+
+  /** Returns the radius of curvature */
+  double getRadiusOfCurvature() const { return R; };
+private:
+  double R{1.0};
 };
 #endif
@@ -95,6 +95,12 @@ public:
   /** Set solver */
   void setSolver( Solver &solv );
 
+  /** Set the number of threads used in FFTs. If 0, the maximum number of OpenMP threads is used */
+  void setNumberOfThreads( unsigned int nThreads );
+
+  /** Get the number of threads used in FFTs */
+  unsigned int getNumberOfThreads() const { return numberOfThreads; };
+
   /** Get name of the waveguide simulation */
   std::string getName() const { return name; };
 
@@ -125,6 +131,9 @@ public:
   /** Get 2D solver */
   const Solver& getSolver() const { return *solver; };
 
+  /** Get the source given to setBoundaryConditions. NULL if the boundary conditions are not set */
+  const ParaxialSource* getSource() const { return src; };
+
   /** Get the array index closest to x, z */
   void closestIndex( double x, double z, unsigned int &ix, unsigned int &iz ) const;
 
@@ -161,6 +170,15 @@ public:
   virtual void getXrayMatProp( double x, double z, double &delta, double &beta ) const;
   virtual void getXrayMatProp( double x, double y, double z, double &delta, double &beta ) const;
 
+  /** Return true if the line integrals of the material properties can be computed directly */
+  virtual bool hasAnalyticProjection() const;
+
+  /** Get the integrals of delta and beta along the line through (x,y) from zmin to zmax */
+  virtual void getProjectedXrayMatProp( double x, double y, double zmin, double zmax, double &deltaInt, double &betaInt ) const;
+
+  /** Return true if the material properties do not depend on z. Solvers can then tabulate them once */
+  virtual bool materialIsZIndependent() const { return false; };
+
   /** Save results to HDF5 file */
   virtual void save( const char* fname );
 
@@ -197,6 +215,7 @@ protected:
   std::vector<H5Attr> commonAttributes;
   std::vector<post::PostProcessingModule*> postProcess;
   int uid{0};
+  unsigned int numberOfThreads{0};
 
   /** Get exit field */
   void getExitField( arma::cx_vec &vec ) const;
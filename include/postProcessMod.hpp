@@ -1,6 +1,7 @@
 #ifndef POST_PROCESS_INTENSITY_H
 #define POST_PROCESS_INTENSITY_H
 #include "postProcessing.hpp"
+#include "fftPlanManager.hpp"
 #include <armadillo>
 
 class ParaxialSimulation;
@@ -103,6 +104,9 @@ public:
 
   /** Add attributes */
   virtual void addAttrib( std::vector<H5Attr> &attr ) const override final;
+
+  /** Set the rigor used when FFTW creates plans */
+  void setPlanRigor( PlanRigor_t rigor ){ plans.setRigor( rigor ); };
 private:
   enum class Dir_t{X,Y};
   unsigned int signalLength{0};
@@ -111,6 +115,7 @@ private:
   const ParaxialSimulation *sim{NULL};
   Pad_t padding{Pad_t::ZERO};
   const arma::cx_mat *reference{NULL};
+  FFTPlanManager plans;
 
   /** Computes the index in the far field array corresponding to a certain angle */
   unsigned int farFieldAngleToIndx( double angle, unsigned int size, Dir_t direction ) const;
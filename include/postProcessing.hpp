@@ -12,6 +12,7 @@ class PostProcessingModule
 public:
   enum class ReturnType_t { vector1D, matrix2D, cube3D };
   PostProcessingModule(const char* name ):name(name){};
+  virtual ~PostProcessingModule(){};
 
   /** Returns the result */
   virtual void result( const Solver& solver, arma::cube& res ){};
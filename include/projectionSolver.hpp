@@ -7,8 +7,29 @@ class ProjectionSolver: public Solver3D
 public:
   ProjectionSolver(): Solver3D("ProjectionSolver"){};
 
+  /** Propagate one step. In single precision the field is only copied to the double arrays at the stored planes */
+  virtual void step() override;
+
+  /** Set the precision used internally */
+  void setPrecision( Precision_t newPrecision ){ precision = newPrecision; };
+
+  /**
+  * Enable/disable the single pass mode. If the material supports it, delta and beta are integrated analytically
+  * along each ray, and only the stored planes are evaluated. Otherwise the solver falls back to slices
+  */
+  void setAnalyticProjection( bool enable ){ analyticProjection = enable; };
 protected:
   /** Propagates the solution one step */
   void solveStep( unsigned int step );
+private:
+  Precision_t precision{Precision_t::DOUBLE};
+  arma::cx_fmat fieldSingle;
+
+  bool analyticProjection{false};
+  bool printFallbackWarning{true};
+  unsigned int lastAnalyticStep{0};
+
+  /** Multiplies the field with the transmission from the last evaluated plane to the plane at step */
+  void analyticStep( unsigned int step );
 };
 #endif
@@ -0,0 +1,91 @@
+#ifndef SCENE_RUNNER_H
+#define SCENE_RUNNER_H
+#include <json/value.h>
+#include <string>
+#include <vector>
+#include "genericScattering.hpp"
+#include "geometry.hpp"
+#include "materialFunction.hpp"
+#include "postProcessing.hpp"
+
+/**
+* Builds a GenericScattering simulation from a JSON scene. The scene contains the CSG geometry, the beam,
+* the discretization, the solver settings and the post processing modules. Examples/sphereScene.json
+* lists all the keys. The runner owns all objects referenced by the simulation
+*/
+class SceneRunner
+{
+public:
+  SceneRunner(){};
+  SceneRunner( const SceneRunner &other ) = delete;
+  SceneRunner& operator =( const SceneRunner &other ) = delete;
+  ~SceneRunner();
+
+  /** Reads and builds the scene in a JSON file */
+  void load( const std::string &fname );
+
+  /** Builds the scene from a parsed JSON object. A previously built scene is destroyed */
+  void build( const Json::Value &scene );
+
+  /** Solves the scene (or runs the scan if the scene has one) and saves the result to the output file */
+  void run();
+
+  /** Returns true if the scene contains a scan */
+  bool hasScan() const { return !scanPoints.empty(); };
+
+  /** Returns the simulation */
+  GenericScattering& getSimulation();
+
+  /** Returns the name of the output file */
+  const std::string& getOutputFile() const { return outputFile; };
+private:
+  GenericScattering *simulation{NULL};
+  CSGMaterial *material{NULL};
+  std::vector<geom::Shape*> shapes;
+  std::vector<geom::Part*> parts;
+  std::vector<geom::Module*> modules;
+  std::vector<post::PostProcessingModule*> postProcess;
+  std::vector<ScanPoint> scanPoints;
+  unsigned int scanModule{0};
+  std::string outputFile{""};
+
+  /** Deletes all objects */
+  void clear();
+
+  /** Reads the simulation parameters */
+  void readDomain( const Json::Value &domain );
+  void readSolver( const Json::Value &solver );
+  void readMaterial( const Json::Value &mat );
+  void readPostProcessing( const Json::Value &modules );
+  void readScan( const Json::Value &scan );
+
+  /** Creates the objects of the CSG tree */
+  geom::Module* createModule( const Json::Value &obj );
+  geom::Part* createPart( const Json::Value &obj );
+  geom::Shape* createShape( const Json::Value &obj );
+
+  /** Applies a list of transformations to a shape, part or module */
+  template<class T>
+  static void applyTransforms( const Json::Value &transforms, T &object );
+
+  /** Prints a warning for keys that are not recognized, as they usually are spelling mistakes */
+  static void checkKeys( const Json::Value &obj, const std::vector<std::string> &known, const std::string &context );
+
+  /** Returns the value of key, which has to be present */
+  static const Json::Value& required( const Json::Value &obj, const char* key, const std::string &context );
+
+  /** Returns a number. If the key is missing, the default value is returned */
+  static double getDouble( const Json::Value &obj, const char* key, double defaultValue, const std::string &context );
+  static unsigned int getUint( const Json::Value &obj, const char* key, unsigned int defaultValue, const std::string &context );
+  static bool getBool( const Json::Value &obj, const char* key, bool defaultValue, const std::string &context );
+  static std::string getString( const Json::Value &obj, const char* key, const std::string &defaultValue, const std::string &context );
+
+  /** Converts names to enums. The comparison is case insensitive */
+  static geom::Axis_t axisFromString( const std::string &name );
+  static GenericScattering::SolverType_t solverFromString( const std::string &name );
+  static GenericScattering::Reference_t referenceFromString( const std::string &name );
+  static Splitting_t splittingFromString( const std::string &name );
+  static Precision_t precisionFromString( const std::string &name );
+  static PlanRigor_t rigorFromString( const std::string &name );
+};
+#endif
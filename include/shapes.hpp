@@ -12,6 +12,7 @@ namespace geom
   {
   public:
     Shape( const char* name );
+    virtual ~Shape(){};
 
     /** Returns true if a point is inside the object */
     virtual bool isInside( double x, double y, double z ) const = 0;
@@ -22,6 +23,12 @@ namespace geom
     /** Return a clone of this object */
     virtual Shape* clone() = 0;
 
+    /**
+    * Computes the interval [zEnter,zExit] where the line through (x,y) parallel to the z-axis is inside the shape.
+    * Returns false if the line does not intersect the shape
+    */
+    virtual bool zInterval( double x, double y, double &zEnter, double &zExit ) const = 0;
+
     /** Returns the code segment that represents the object */
     void openSCADExport( std::string &code ) const;
 
@@ -43,6 +50,9 @@ namespace geom
     /** Get the transformation matrix */
     const arma::mat& getTransformation() const { return transformation; };
 
+    /** Set the transformation matrix */
+    void setTransformation( const arma::mat &newTransformation ){ transformation = newTransformation; };
+
     /** Computes the inverse transformation matrix */
     void getInverseTransformation( arma::mat &inverse ) const;
 
@@ -51,6 +61,9 @@ namespace geom
   protected:
     std::string name;
     arma::mat transformation;
+
+    /** Origin and direction of the line through (x,y) parallel to the z-axis in the coordinates of the shape */
+    void localLine( double x, double y, double origin[3], double direction[3] ) const;
   };
 
   /** A class that implements a sphere */
@@ -67,6 +80,9 @@ namespace geom
 
     /** Returns a pointer to a clone of this class */
     virtual Shape* clone() override { return new Sphere(*this); };
+
+    /** Solves the quadratic equation of the surface */
+    virtual bool zInterval( double x, double y, double &zEnter, double &zExit ) const override final;
   protected:
     double radius{0.0};
   };
@@ -85,6 +101,9 @@ namespace geom
 
     /** Returns a pointer to a clone of this box */
     virtual Shape* clone() override { return new Box(*this); };
+
+    /** Intersects the line with the three pairs of faces */
+    virtual bool zInterval( double x, double y, double &zEnter, double &zExit ) const override final;
   protected:
     double Lx;
     double Ly;
@@ -105,6 +124,9 @@ namespace geom
 
     /** Returns a pointer to a clone of this object */
     virtual Shape* clone() override { return new Cylinder(*this); };
+
+    /** Intersects the line with the end faces and the conical surface */
+    virtual bool zInterval( double x, double y, double &zEnter, double &zExit ) const override final;
   protected:
     double r1;
     double r2;
@@ -0,0 +1,107 @@
+#ifndef SIMULATION_SCHEDULER_H
+#define SIMULATION_SCHEDULER_H
+#include <string>
+#include <vector>
+class ParaxialSimulation;
+
+/** How the threads of a job are bound to the cores. CORES binds each thread to one core, NUMA binds the team to one node */
+enum class Affinity_t {NONE, CORES, NUMA};
+
+/**
+* Runs independent simulations at the same time. The cores are split into slots, and each running job
+* gets its own team of OpenMP threads in one slot. This fills a node with sweep points instead of
+* running one simulation on more threads than it scales to.
+* The jobs must not share solvers, post processing modules or sources, and real time visualization
+* should be disabled. FFTW planning and saving to HDF5 are serialized.
+*/
+class SimulationScheduler
+{
+public:
+  SimulationScheduler(){};
+
+  /** Adds a job. If fname is not empty, the results are saved to this file when the job has finished */
+  void add( ParaxialSimulation &sim, const std::string &fname="" );
+
+  /** Sets the number of jobs that run at the same time. If 0, it is derived from the number of cores */
+  void setConcurrentJobs( unsigned int nJobs ){ concurrentJobs = nJobs; };
+
+  /** Sets the number of threads of each job. If 0, the cores are divided evenly among the concurrent jobs */
+  void setThreadsPerJob( unsigned int nThreads ){ threadsPerJob = nThreads; };
+
+  /** Sets how the threads are bound to the cores. The threads are unbound after each job. Ignored if OMP_PROC_BIND is set */
+  void setAffinity( Affinity_t newAffinity ){ affinity = newAffinity; };
+
+  /** Runs all jobs. An exception in one job does not stop the others. Returns the number of failed jobs */
+  unsigned int run();
+
+  /** Returns the number of jobs */
+  unsigned int numberOfJobs() const { return jobs.size(); };
+
+  /** Returns true if the job finished without errors */
+  bool succeeded( unsigned int job ) const;
+
+  /** Returns the error message of a failed job */
+  const std::string& getError( unsigned int job ) const;
+
+  /** Returns the wall time of the job in seconds */
+  double getWallTime( unsigned int job ) const;
+
+  /** Returns the slot the job ran in */
+  unsigned int getSlot( unsigned int job ) const;
+
+  /** Prints a summary of the last run */
+  void printSummary() const;
+
+  /** Removes all jobs */
+  void clear(){ jobs.clear(); };
+private:
+  struct Job
+  {
+    ParaxialSimulation *sim{NULL};
+    std::string fname{""};
+    bool finished{false};
+    bool failed{false};
+    std::string error{""};
+    double wallTime{0.0};
+    unsigned int slot{0};
+  };
+
+  std::vector<Job> jobs;
+  unsigned int concurrentJobs{0};
+  unsigned int threadsPerJob{0};
+  Affinity_t affinity{Affinity_t::NONE};
+
+  /** Binding used in the current run. NONE if the OpenMP runtime binds the threads */
+  Affinity_t activeAffinity{Affinity_t::NONE};
+
+  /** CPUs assigned to each slot */
+  std::vector< std::vector<int> > slotCpus;
+
+  /** CPUs of the calling thread when the run started. The threads are bound to these again after each job */
+  std::vector<int> processCpus;
+
+  /** Splits the available CPUs into slots and sets the number of slots and threads per slot */
+  void setupSlots( unsigned int &nSlots, unsigned int &nThreads );
+
+  /** Runs one job on the calling thread with a nested team of nThreads threads */
+  void runJob( Job &job, unsigned int slot, unsigned int nThreads );
+
+  /** Returns the CPUs thread number thread in a slot is bound to */
+  std::vector<int> threadCpus( unsigned int slot, unsigned int thread ) const;
+
+  /** Binds the calling thread to the CPUs. Returns false if binding is not supported */
+  static bool bindThread( const std::vector<int> &cpus );
+
+  /** Returns the job, throws if the index is out of range */
+  const Job& getJob( unsigned int job ) const;
+
+  /** Returns the CPUs the process is allowed to run on */
+  static std::vector<int> availableCpus();
+
+  /** Returns the CPUs of each NUMA node. Empty if the topology cannot be read */
+  static std::vector< std::vector<int> > numaNodes();
+
+  /** Parses a CPU list of the form 0-3,8,10-11 */
+  static std::vector<int> parseCpuList( const std::string &list );
+};
+#endif
@@ -6,6 +6,12 @@
 
 class ParaxialSimulation;
 
+/** Operator splitting used by the split-step solvers. LIE is first order, STRANG is second order */
+enum class Splitting_t{LIE, STRANG};
+
+/** Floating point precision used internally by the solvers that support it */
+enum class Precision_t{DOUBLE, SINGLE};
+
 /** Base class for all solvers */
 class Solver
 {
@@ -29,6 +35,12 @@ public:
   /** Reset the counter */
   virtual void reset(){ currentStep = 1; };
 
+  /** Set the number of threads used in FFTs. If 0, the maximum number of OpenMP threads is used */
+  virtual void setNumberOfThreads( unsigned int nThreads ){ numberOfThreads = nThreads; };
+
+  /** Get the number of threads used in FFTs */
+  unsigned int getNumberOfThreads() const { return numberOfThreads; };
+
   /** Get solution 3D  */
   virtual const arma::cx_cube& getSolution3D() const;
 
@@ -71,6 +83,7 @@ protected:
   visa::GaussianKernel kernel;
   visa::LowPassFilter filter;
   unsigned int currentStep{1};
+  unsigned int numberOfThreads{0};
 };
 
 #endif
@@ -32,6 +32,9 @@ public:
   /** Set paraxial equation to solve */
   void setEquation( const ParaxialEquation &equation );
 
+  /** Get the paraxial equation that is solved */
+  const ParaxialEquation& getEquation() const { return *eq; };
+
   /** Set the simulator */
   void setSimulator( ParaxialSimulation &newGuide ) override;
 
@@ -83,6 +86,23 @@ public:
   /** Set which boundary conditions to use. Dirichlet is default */
   void setBoundaryCondition( BC_t bc ){ boundaryCondition = bc; };
 
+  /**
+  * Enables error controlled step sizes. The substeps are chosen by step doubling, such that the relative difference
+  * between one full step and two half steps stays below tolerance. The substeps land exactly on every
+  * downsamplingRatio grid plane and on the last plane, and the grid planes in between are interpolated linearly.
+  * Substeps are never shorter than minStep or longer than the spacing of the landing planes
+  */
+  void setAdaptiveStepping( double tolerance, double minStep );
+
+  /** Returns to fixed steps equal to the grid step */
+  void disableAdaptiveStepping(){ adaptive.enabled = false; };
+
+  /** Number of accepted substeps since the last reset */
+  unsigned int getNumberOfAcceptedSubsteps() const { return adaptive.nAccepted; };
+
+  /** Number of rejected substeps since the last reset */
+  unsigned int getNumberOfRejectedSubsteps() const { return adaptive.nRejected; };
+
   /** Function that disables the longitudinal filtering */
   void disableLongitudinalFilter(){ longitudinalFilterDisabled = true; };
 
@@ -104,10 +124,38 @@ protected:
   double stepZ{1.0};
   double xmin{0.0};
   double zmin{0.0};
+  double stepStartZ{0.0}; // z-coordinate at the start of the step solved by solveStep
   double wavenumber{1.0};
   BC_t boundaryCondition{BC_t::DIRICHLET};
   bool longitudinalFilterDisabled{false}; // Flag for completely disable longitudinal filter
 
+  /** Parameters and state of the adaptive step size control */
+  struct AdaptiveStepping
+  {
+    bool enabled{false};
+    double tolerance{1E-4};
+    double minStep{0.0};
+    double step{0.0}; // Size of the next substep, 0 means the grid step
+    unsigned int nAccepted{0};
+    unsigned int nRejected{0};
+    double zBehind{0.0}; // Landing planes around the current grid plane
+    double zAhead{0.0};
+  };
+  AdaptiveStepping adaptive;
+  arma::cx_vec adaptiveStart;
+  arma::cx_vec adaptiveFullStep;
+  arma::cx_vec adaptiveBehind;
+  arma::cx_vec adaptiveAhead;
+
+  /** Advances to the next landing plane if needed. On return the solution at the grid plane is in currentSolution */
+  void adaptiveStep();
+
+  /** Integrates the field in prevSolution from zStart to zEnd with adaptive substeps. The result is in currentSolution */
+  void integrateAdaptive( double zStart, double zEnd, double maxStep );
+
+  /** Order of accuracy in z of solveStep. Used to scale the error estimate of the step doubling */
+  virtual unsigned int orderOfAccuracy() const { return 2; };
+
   /** Get the solution */
   arma::cx_mat& getSolution( unsigned int iz ) { return *solution; };
 
@@ -117,7 +165,7 @@ protected:
   /** Copies the solution in to the solution matrix */
   void copyCurrentSolution( unsigned int step );
 
-  /** Solve one step */
+  /** Solve one step of length stepZ starting at stepStartZ */
   virtual void solveStep( unsigned int step ) = 0;
 
   /** Set the required parameters from the waveguide object */
@@ -44,6 +44,12 @@ public:
   /** Set the plot limits */
   void setPlotLimits( double intensityMin, double intensityMax, double phaseMin, double phaseMax, bool intensityLogScale );
 
+  /**
+  * Enable/disable storing the planes in the 3D solution. If disabled, only the last plane is kept and the
+  * solution cube is not allocated. Takes effect the next time the simulator is set
+  */
+  void setStoreSolution( bool store ){ storeSolution = store; };
+
   /** Updates the dimensions of the arrays */
   virtual void updateDimensionsOfArrays() override;
 protected:
@@ -51,6 +57,10 @@ protected:
   arma::cx_mat *currentSolution{NULL};
   arma::cx_mat *prevSolution{NULL};
   bool logScaleIntensity{false};
+  bool storeSolution{true};
+
+  /** The warning about planes outside the solution array is only printed once per solver */
+  bool printOutOfBoundsWarning{true};
 
   // Some parameters
   unsigned int Nx, Ny, Nz;
@@ -61,6 +71,12 @@ protected:
   /** Copy the current solution to the previous array */
   void copyCurrentSolution( unsigned int step );
 
+  /** Stores the field in the solution array if step is one of the downsampled planes */
+  void storeSlice( const arma::cx_mat &field, unsigned int step );
+
+  /** Returns true if the field at the given step is stored or is the last one */
+  bool isStoredStep( unsigned int step ) const;
+
   /** Solver specific function to propagate one step */
   virtual void solveStep( unsigned int step ) = 0;
 
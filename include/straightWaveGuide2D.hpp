@@ -0,0 +1,29 @@
+#ifndef WAVE_GUIDE_STRAIGHT_2D_H
+#define WAVE_GUIDE_STRAIGHT_2D_H
+#include "waveGuideFDSimulation.hpp"
+
+/** Straight waveguide along the z-axis occupying 0 < x < width */
+class StraightWaveGuideFD: public WaveGuideFDSimulation
+{
+public:
+  StraightWaveGuideFD(): WaveGuideFDSimulation("StraightWaveGuide2D"){};
+
+  /** Set the width of the waveguide in nano meters */
+  void setWidth( double newWidth ){ width = newWidth; };
+
+  /** Get the width of the waveguide in nano meters */
+  double getWidth() const { return width; };
+
+  // Virtual functions
+  /** Fill a JSON object with parameters specific to straight waveguides */
+  virtual void fillInfo( Json::Value &obj ) const override;
+
+  /** Checks if the coordinates given is inside the waveguide */
+  virtual bool isInsideGuide( double x, double z ) const override;
+
+  /** The material does not depend on z as long as the waveguide does not end inside the domain */
+  virtual bool materialIsZIndependent() const override;
+protected:
+  double width{100.0};
+};
+#endif
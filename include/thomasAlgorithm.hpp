@@ -1,16 +1,83 @@
 #ifndef THOMAS_ALGORITHM_H
 #define THOMAS_ALGORITHM_H
+#include <complex>
+#include "workspace.hpp"
 
 /** Class for solving tridiagonal systems of equations */
 class ThomasAlgorithm
 {
 public:
   ThomasAlgorithm(){};
+  ThomasAlgorithm( const ThomasAlgorithm &other ) = delete;
+  ThomasAlgorithm& operator=( const ThomasAlgorithm &other ) = delete;
+  ~ThomasAlgorithm();
 
   // On return the solution is stored in diag. NOTE: rhs is modified
-  /** Solve the system of equations */
+  /** Solve the system of equations. Allocates a scratch array, use the version below in loops */
   template <class T>
   void solve( T diag[], const T subdiag[], T rhs[], unsigned int N) const;
+
+  /** Solve the system of equations using supdiag (length N-1) as scratch array */
+  template <class T>
+  void solve( T diag[], const T subdiag[], T rhs[], unsigned int N, T supdiag[] ) const;
+
+  /**
+  * Solve nSystems independent systems of length N stored one after another.
+  * The subdiagonal of system n starts at subdiag[n*N], the last element of each is not used.
+  * The systems are distributed among the OpenMP threads. On return the solutions are stored in diag
+  */
+  template <class T>
+  void solveBatch( T diag[], const T subdiag[], T rhs[], unsigned int N, unsigned int nSystems );
+
+  /** Complex double version of solveBatch. Groups of LANES systems are solved with solveInterleaved */
+  void solveBatch( std::complex<double> diag[], const std::complex<double> subdiag[], std::complex<double> rhs[],
+                   unsigned int N, unsigned int nSystems );
+
+  /**
+  * Solves one system by splitting it into one partition per OpenMP thread. The partitions are solved
+  * concurrently, coupled through a small reduced system of the nodes separating them, and corrected.
+  * Systems shorter than two partitions of MIN_NODES_PER_PARTITION are solved with the serial algorithm.
+  * On return the solution is stored in diag. NOTE: rhs is modified
+  */
+  template <class T>
+  void solvePartitioned( T diag[], const T subdiag[], T rhs[], unsigned int N );
+
+  /** Partitions are at least this long, shorter ones are dominated by the synchronisation */
+  static const unsigned int MIN_NODES_PER_PARTITION = 16384;
+
+  /** Allocates the per thread scratch memory needed by solveBatch for systems of length N */
+  void reserve( unsigned int N );
+
+  /** Number of systems solved simultaneously by solveInterleaved */
+  static const unsigned int LANES = 8;
+
+  /**
+  * Solves LANES complex systems of length N at once. The systems are stored interleaved,
+  * element i of system l is at index i*LANES+l, with real and imaginary parts in separate arrays.
+  * subRe/subIm has length N*LANES, the last LANES elements are not used.
+  * supRe/supIm are scratch arrays of length N*LANES. On return the solutions are stored in diagRe/diagIm
+  */
+  void solveInterleaved( double diagRe[], double diagIm[], const double subRe[], const double subIm[],
+                         double rhsRe[], double rhsIm[], unsigned int N, double supRe[], double supIm[] ) const;
+private:
+  /** One workspace per OpenMP thread */
+  Workspace *threadWorkspaces{NULL};
+  unsigned int nWorkspaces{0};
+
+  /** Scratch memory of solvePartitioned */
+  Workspace partitionWorkspace;
+
+  /** Eliminates the partition from row first to row last. Stores the local solution in diag and the response to
+  * a unit value of the left and right separator, scaled by the coupling coefficients, in left and right */
+  template <class T>
+  void solvePartition( T diag[], const T subdiag[], T rhs[], unsigned int first, unsigned int last,
+                       T couplingLeft, T couplingRight, T supdiag[], T left[], T right[] ) const;
+
+  /** Makes sure there is one workspace for each thread */
+  void allocateThreadWorkspaces();
+
+  /** Number of bytes of scratch memory one thread needs for systems of length N */
+  static std::size_t scratchBytes( unsigned int N );
 };
 
 #include "thomasAlgorithm.tpp"
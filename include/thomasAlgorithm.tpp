@@ -2,9 +2,35 @@
 template <class T>
 void ThomasAlgorithm::solve( T diag[], const T subdiag[], T rhs[], unsigned int N) const
 {
-  // Store a copy of the supdiag
   T *supdiag = new T[N-1]; // Dynamically allocate to avoid stack overflow
-  #pragma omp parallel for
+  solve( diag, subdiag, rhs, N, supdiag );
+  delete [] supdiag;
+}
+
+template <class T>
+void ThomasAlgorithm::solveBatch( T diag[], const T subdiag[], T rhs[], unsigned int N, unsigned int nSystems )
+{
+  allocateThreadWorkspaces();
+
+  #pragma omp parallel
+  {
+    Workspace &ws = threadWorkspaces[omp_get_thread_num()];
+    ws.reserve( Workspace::bytes<T>(N) );
+    T *supdiag = ws.allocate<T>(N);
+
+    #pragma omp for schedule(static)
+    for ( unsigned int n=0;n<nSystems;n++ )
+    {
+      unsigned int start = n*N;
+      solve( &diag[start], &subdiag[start], &rhs[start], N, supdiag );
+    }
+  }
+}
+
+template <class T>
+void ThomasAlgorithm::solve( T diag[], const T subdiag[], T rhs[], unsigned int N, T supdiag[] ) const
+{
+  // Store a copy of the supdiag
   for ( unsigned int i=0;i<N-1;i++ )
   {
     supdiag[i] = subdiag[i];
@@ -28,5 +54,103 @@ void ThomasAlgorithm::solve( T diag[], const T subdiag[], T rhs[], unsigned int
   {
     diag[i] = rhs[i] - supdiag[i]*diag[i+1];
   }
-  delete [] supdiag;
+}
+
+template <class T>
+void ThomasAlgorithm::solvePartitioned( T diag[], const T subdiag[], T rhs[], unsigned int N )
+{
+  unsigned int nParts = omp_get_max_threads();
+  if ( nParts > N/MIN_NODES_PER_PARTITION ) nParts = N/MIN_NODES_PER_PARTITION;
+
+  if ( nParts < 2 )
+  {
+    partitionWorkspace.reserve( Workspace::bytes<T>(N) );
+    solve( diag, subdiag, rhs, N, partitionWorkspace.allocate<T>(N) );
+    return;
+  }
+
+  // The partitions are separated by one node each. The reduced system has one unknown per separator
+  unsigned int nSep = nParts-1;
+  partitionWorkspace.reserve( 3*Workspace::bytes<T>(N) + 4*Workspace::bytes<T>(nSep) );
+  T *supdiag = partitionWorkspace.allocate<T>(N);
+  T *left = partitionWorkspace.allocate<T>(N);
+  T *right = partitionWorkspace.allocate<T>(N);
+  T *redDiag = partitionWorkspace.allocate<T>(nSep);
+  T *redSubdiag = partitionWorkspace.allocate<T>(nSep);
+  T *redRhs = partitionWorkspace.allocate<T>(nSep);
+  T *redSupdiag = partitionWorkspace.allocate<T>(nSep);
+
+  unsigned int *separator = new unsigned int[nSep];
+  for ( unsigned int k=0;k<nSep;k++ )
+  {
+    separator[k] = static_cast<unsigned long>(k+1)*N/nParts;
+  }
+
+  #pragma omp parallel
+  {
+    #pragma omp for schedule(static)
+    for ( unsigned int p=0;p<nParts;p++ )
+    {
+      unsigned int first = ( p == 0 ) ? 0:separator[p-1]+1;
+      unsigned int last = ( p == nParts-1 ) ? N-1:separator[p]-1;
+      T couplingLeft = ( p == 0 ) ? T(0.0):subdiag[first-1];
+      T couplingRight = ( p == nParts-1 ) ? T(0.0):subdiag[last];
+      solvePartition( diag, subdiag, rhs, first, last, couplingLeft, couplingRight, supdiag, left, right );
+    }
+
+    #pragma omp single
+    {
+      // Inserting the partition solutions into the separator rows gives a symmetric tridiagonal system
+      for ( unsigned int k=0;k<nSep;k++ )
+      {
+        unsigned int s = separator[k];
+        redDiag[k] = diag[s] - subdiag[s-1]*right[s-1] - subdiag[s]*left[s+1];
+        redRhs[k] = rhs[s] - subdiag[s-1]*diag[s-1] - subdiag[s]*diag[s+1];
+        redSubdiag[k] = ( k < nSep-1 ) ? -subdiag[s]*right[s+1]:T(0.0);
+      }
+      solve( redDiag, redSubdiag, redRhs, nSep, redSupdiag );
+    }
+
+    #pragma omp for schedule(static)
+    for ( unsigned int p=0;p<nParts;p++ )
+    {
+      unsigned int first = ( p == 0 ) ? 0:separator[p-1]+1;
+      unsigned int last = ( p == nParts-1 ) ? N-1:separator[p]-1;
+      T xLeft = ( p == 0 ) ? T(0.0):redDiag[p-1];
+      T xRight = ( p == nParts-1 ) ? T(0.0):redDiag[p];
+      for ( unsigned int i=first;i<=last;i++ )
+      {
+        diag[i] -= left[i]*xLeft + right[i]*xRight;
+      }
+      if ( p < nParts-1 ) diag[last+1] = xRight;
+    }
+  }
+  delete [] separator;
+}
+
+template <class T>
+void ThomasAlgorithm::solvePartition( T diag[], const T subdiag[], T rhs[], unsigned int first, unsigned int last,
+                                      T couplingLeft, T couplingRight, T supdiag[], T left[], T right[] ) const
+{
+  // Forward step for the right hand side and the left coupling at the same time
+  T invPivot = T(1.0)/diag[first];
+  rhs[first] *= invPivot;
+  left[first] = couplingLeft*invPivot;
+  for ( unsigned int i=first+1;i<=last;i++ )
+  {
+    supdiag[i-1] = subdiag[i-1]*invPivot;
+    invPivot = T(1.0)/( diag[i] - subdiag[i-1]*supdiag[i-1] );
+    rhs[i] = ( rhs[i] - subdiag[i-1]*rhs[i-1] )*invPivot;
+    left[i] = -subdiag[i-1]*left[i-1]*invPivot;
+  }
+
+  // The right coupling only enters the last row, so its forward step is trivial
+  diag[last] = rhs[last];
+  right[last] = couplingRight*invPivot;
+  for ( int i=last-1;i>=static_cast<int>(first);i-- )
+  {
+    diag[i] = rhs[i] - supdiag[i]*diag[i+1];
+    left[i] -= supdiag[i]*left[i+1];
+    right[i] = -supdiag[i]*right[i+1];
+  }
 }
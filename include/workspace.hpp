@@ -0,0 +1,53 @@
+#ifndef WORKSPACE_H
+#define WORKSPACE_H
+#include <cstddef>
+#include <stdexcept>
+
+/**
+* Reusable block of aligned scratch memory. Arrays are handed out from the block with allocate
+* and all of them are released by the next call to reserve, which only reallocates if the block is too small.
+* Hence, solvers that request the same arrays in every step do not allocate memory after the first step
+*/
+class Workspace
+{
+public:
+  Workspace(){};
+  Workspace( const Workspace &other ) = delete;
+  Workspace& operator=( const Workspace &other ) = delete;
+  ~Workspace();
+
+  /** Alignment in bytes of all arrays returned by allocate */
+  static const std::size_t ALIGNMENT = 64;
+
+  /** Makes sure that at least nBytes are available and releases all arrays */
+  void reserve( std::size_t nBytes );
+
+  /** Returns an aligned array of n elements. Throws if the workspace is too small */
+  template<class T>
+  T* allocate( std::size_t n );
+
+  /** Number of bytes occupied by an array of n elements including the alignment padding */
+  template<class T>
+  static std::size_t bytes( std::size_t n ){ return ( (n*sizeof(T)+ALIGNMENT-1)/ALIGNMENT )*ALIGNMENT; };
+
+  /** Returns the size of the workspace in bytes */
+  std::size_t capacity() const { return nBytes; };
+private:
+  char *data{NULL};
+  std::size_t nBytes{0};
+  std::size_t offset{0};
+};
+
+template<class T>
+T* Workspace::allocate( std::size_t n )
+{
+  std::size_t size = bytes<T>(n);
+  if ( offset+size > nBytes )
+  {
+    throw( std::runtime_error("Workspace is too small! Call reserve with the total size of all arrays first") );
+  }
+  T* ptr = reinterpret_cast<T*>( data+offset );
+  offset += size;
+  return ptr;
+}
+#endif
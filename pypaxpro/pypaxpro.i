@@ -18,14 +18,20 @@
   #include "solver2D.hpp"
   #include "solver3D.hpp"
   #include "crankNicholson.hpp"
+  #include "batchedCrankNicholson.hpp"
+  #include "simulationScheduler.hpp"
+  #include "fftPlanManager.hpp"
   #include "fftSolver2D.hpp"
   #include "fftSolver3D.hpp"
+  #include "hankelSolver3D.hpp"
   #include "alternatingDirectionSolver.hpp"
   #include "planeWave.hpp"
 %}
 
+%include "fftPlanManager.hpp"
 %include "paraxialSimulation.hpp"
 %include "genericScattering.hpp"
+%template(ScanPointVector) std::vector<ScanPoint>;
 %include "shapes.hpp"
 %include "geometry.hpp"
 %include "materialFunction.hpp"
@@ -37,7 +43,10 @@
 %include "solver2D.hpp"
 %include "solver3D.hpp"
 %include "crankNicholson.hpp"
+%include "batchedCrankNicholson.hpp"
+%include "simulationScheduler.hpp"
 %include "fftSolver2D.hpp"
 %include "fftSolver3D.hpp"
+%include "hankelSolver3D.hpp"
 %include "alternatingDirectionSolver.hpp"
 %include "planeWave.hpp"
@@ -8,9 +8,11 @@ using namespace std;
 void ADI::xImplicit( unsigned int step )
 {
   assert( guide != NULL );
-  cdouble *diag = new cdouble[Nx*Ny];
-  cdouble *subdiag = new cdouble[Nx*Ny-1];
-  cdouble *rhs = new cdouble[Nx*Ny];
+  workspace.reserve( workspaceBytes() );
+  cdouble *diag = workspace.allocate<cdouble>(Nx*Ny);
+  cdouble *subdiag = workspace.allocate<cdouble>(Nx*Ny);
+  cdouble *rhs = workspace.allocate<cdouble>(Nx*Ny);
+  cdouble *fieldT = workspace.allocate<cdouble>(Nx*Ny);
   cdouble im(0.0,1.0);
 
   dx = guide->transverseDiscretization().step;
@@ -19,13 +21,15 @@ void ADI::xImplicit( unsigned int step )
   k = guide->getWavenumber();
 
   double z = guide->getZ(step);
-  double delta, beta;
+
+  // The lines are rows of the field. In the transposed copy they are contiguous
+  blockedTranspose( prevSolution->memptr(), Ny, Nx, fieldT );
 
   #ifdef ADI_DEBUG
     clog << "Building matrix...\n";
   #endif
 
-  // Build matrix system
+  // Build matrix system. fieldT[i*Nx+j] holds the field at row i and column j
   #pragma omp parallel for
   for ( unsigned int indx=0;indx<Nx*Ny;indx++ )
   {
@@ -33,21 +37,21 @@ void ADI::xImplicit( unsigned int step )
     unsigned int i = indx/Nx;
     double x = guide->getX(j);
     double y = guide->getY(i);
+    double delta, beta;
     guide->getXrayMatProp(x,y,z,delta,beta);
-    //unsigned int indx = i*Nx+j;
     diag[indx] = 1.0/dz + im/(k*dx*dx) + beta*k + im*delta*k ;
-    rhs[indx] = ( 1.0/dz - im/(k*dy*dy) )*(*prevSolution)(i,j);
+    rhs[indx] = ( 1.0/dz - im/(k*dy*dy) )*fieldT[indx];
     if ( j>0 )
     {
       subdiag[indx-1] = -0.5*im/(k*dx*dx);
     }
     if ( i > 0 )
     {
-      rhs[indx] += 0.5*im*(*prevSolution)(i-1,j)/(k*dy*dy);
+      rhs[indx] += 0.5*im*fieldT[indx-Nx]/(k*dy*dy);
     }
     if ( i<Ny-1 )
     {
-      rhs[indx] += 0.5*im*(*prevSolution)(i+1,j)/(k*dy*dy);
+      rhs[indx] += 0.5*im*fieldT[indx+Nx]/(k*dy*dy);
     }
   }
   if ( useTBC ) applyTBC( diag, rhs, ImplicitDirection_t::X );
@@ -55,32 +59,24 @@ void ADI::xImplicit( unsigned int step )
   #ifdef ADI_DEBUG
     clog << "Solving matrix...\n";
   #endif
-  // Solve the system
-  matrixSolver.solve( diag, subdiag, rhs, Nx*Ny );
+  // Solve the system. Each row of the field is an independent system
+  matrixSolver.solveBatch( diag, subdiag, rhs, Nx, Ny );
 
   #ifdef ADI_DEBUG
     clog << "Transferring solution to currentSolution array...\n";
   #endif
 
-  // Copy the solution to the current solution
-  #pragma omp parallel for
-  for ( unsigned int indx=0;indx<Nx*Ny;indx++ )
-  {
-    unsigned int i = indx/Nx;
-    unsigned int j = indx%Nx;
-    (*currentSolution)(i,j) = diag[indx];
-  }
-  delete [] diag;
-  delete [] subdiag;
-  delete [] rhs;
+  // Transpose the solution back to the current solution
+  blockedTranspose( diag, Nx, Ny, currentSolution->memptr() );
 }
 
 void ADI::yImplicit( unsigned int step )
 {
   assert( guide != NULL );
-  cdouble *diag = new cdouble[Nx*Ny];
-  cdouble *subdiag = new cdouble[Nx*Ny-1];
-  cdouble *rhs = new cdouble[Nx*Ny];
+  workspace.reserve( workspaceBytes() );
+  cdouble *diag = workspace.allocate<cdouble>(Nx*Ny);
+  cdouble *subdiag = workspace.allocate<cdouble>(Nx*Ny);
+  cdouble *rhs = workspace.allocate<cdouble>(Nx*Ny);
   cdouble im(0.0,1.0);
 
   dx = guide->transverseDiscretization().step;
@@ -89,9 +85,11 @@ void ADI::yImplicit( unsigned int step )
   k = guide->getWavenumber();
 
   double z = guide->getZ(step) + dz;
-  double delta, beta;
 
-  // Build matrix system
+  // The lines are columns of the field, which are contiguous in memory
+  const cdouble *field = prevSolution->memptr();
+
+  // Build matrix system. field[i*Ny+j] holds the field at row j and column i
   #pragma omp parallel for
   for ( unsigned int indx=0;indx<Nx*Ny;indx++ )
   {
@@ -99,38 +97,84 @@ void ADI::yImplicit( unsigned int step )
     unsigned int j = indx%Ny;
     double x = guide->getX(i);
     double y = guide->getY(j);
+    double delta, beta;
     guide->getXrayMatProp(x,y,z,delta,beta);
-    diag[indx] = 1.0/dz + im/(k*dy*dy + beta*k + im*delta*k );
-    rhs[indx] = (-im/(k*dx*dx) + 1.0/dz)*(*prevSolution)(j,i);
+    diag[indx] = 1.0/dz + im/(k*dy*dy) + beta*k + im*delta*k;
+    rhs[indx] = (-im/(k*dx*dx) + 1.0/dz)*field[indx];
     if ( j>0 )
     {
       subdiag[indx-1] = -0.5*im/(k*dy*dy);
     }
     if ( i > 0 )
     {
-      rhs[indx] += 0.5*im*(*prevSolution)(j,i-1)/(k*dx*dx);
+      rhs[indx] += 0.5*im*field[indx-Ny]/(k*dx*dx);
     }
-    if ( i<Ny-1 )
+    if ( i<Nx-1 )
     {
-      rhs[indx] += 0.5*im*(*prevSolution)(j,i+1)/(k*dx*dx);
+      rhs[indx] += 0.5*im*field[indx+Ny]/(k*dx*dx);
     }
   }
   if ( useTBC ) applyTBC( diag, rhs, ImplicitDirection_t::Y );
 
-  // Solve the system
-  matrixSolver.solve( diag, subdiag, rhs, Nx*Ny );
+  // Solve the system. Each column of the field is an independent system
+  matrixSolver.solveBatch( diag, subdiag, rhs, Ny, Nx );
 
-  // Copy the solution to the current solution
+  // Copy the solution to the current solution, the layouts are identical
+  cdouble *out = currentSolution->memptr();
   #pragma omp parallel for
   for ( unsigned int indx=0;indx<Nx*Ny;indx++ )
   {
-    unsigned int i = indx/Ny;
-    unsigned int j = indx%Ny;
-    (*currentSolution)(j,i) = diag[indx];
+    out[indx] = diag[indx];
   }
-  delete [] diag;
-  delete [] subdiag;
-  delete [] rhs;
+}
+
+void ADI::setSimulator( ParaxialSimulation &sim )
+{
+  Solver3D::setSimulator( sim );
+  workspace.reserve( workspaceBytes() );
+  matrixSolver.reserve( Nx > Ny ? Nx:Ny );
+}
+
+size_t ADI::workspaceBytes() const
+{
+  return 4*Workspace::bytes<cdouble>(Nx*Ny);
+}
+
+void ADI::blockedTranspose( const cdouble src[], unsigned int nRows, unsigned int nCols, cdouble dest[] )
+{
+  // 32x32 blocks of complex doubles (16 kB) fit in L1 for both the source and the destination
+  const unsigned int BLOCK = 32;
+  unsigned int nBlockRows = ( nRows+BLOCK-1 )/BLOCK;
+  unsigned int nBlockCols = ( nCols+BLOCK-1 )/BLOCK;
+
+  #pragma omp parallel for schedule(static)
+  for ( unsigned int b=0;b<nBlockRows*nBlockCols;b++ )
+  {
+    unsigned int rowStart = ( b%nBlockRows )*BLOCK;
+    unsigned int colStart = ( b/nBlockRows )*BLOCK;
+    unsigned int rowEnd = rowStart+BLOCK < nRows ? rowStart+BLOCK:nRows;
+    unsigned int colEnd = colStart+BLOCK < nCols ? colStart+BLOCK:nCols;
+    for ( unsigned int col=colStart;col<colEnd;col++ )
+    {
+      for ( unsigned int row=rowStart;row<rowEnd;row++ )
+      {
+        dest[row*nCols+col] = src[col*nRows+row];
+      }
+    }
+  }
+}
+
+double ADI::bytesPerYHalfStep() const
+{
+  // Assembly reads the field and writes diag, subdiag and rhs. The batched Thomas solver reads these three
+  // arrays and writes the solution, and the copy back reads and writes one array
+  return 10.0*sizeof(cdouble)*static_cast<double>(Nx)*Ny;
+}
+
+double ADI::bytesPerXHalfStep() const
+{
+  // Same as the y-sweep plus the transpose of the field into the workspace
+  return 12.0*sizeof(cdouble)*static_cast<double>(Nx)*Ny;
 }
 
 void ADI::solveStep( unsigned int step )
@@ -140,7 +184,9 @@ void ADI::solveStep( unsigned int step )
     clog << "Prev max/min: " << prevSolution->max() << " " << prevSolution->min() << " ";
     clog << "- Cur max/min: " << currentSolution->max() << " " << currentSolution->min() << endl;
   #endif
+  double start = omp_get_wtime();
   xImplicit(step);
+  xImplicitTime += omp_get_wtime()-start;
 
   #ifdef ADI_DEBUG
     clog << "Copy solution to previous array...\n";
@@ -151,7 +197,9 @@ void ADI::solveStep( unsigned int step )
   #ifdef ADI_DEBUG
     clog << "Solving Y implicitly...\n";
   #endif
+  start = omp_get_wtime();
   yImplicit(step);
+  yImplicitTime += omp_get_wtime()-start;
 }
 
 void ADI::applyTBC( cdouble diag[], cdouble rhs[], ImplicitDirection_t dir )
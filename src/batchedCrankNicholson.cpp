@@ -0,0 +1,242 @@
+#include "batchedCrankNicholson.hpp"
+#include "paraxialSimulation.hpp"
+#include "paraxialSource.hpp"
+#include "paraxialEquation.hpp"
+#include "solver2D.hpp"
+#include <H5Cpp.h>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <typeinfo>
+
+using namespace std;
+
+void BatchedCrankNicholson::addSimulation( const ParaxialSimulation &sim, double sweepValue )
+{
+  if ( sim.getSource() == nullptr )
+  {
+    throw( runtime_error("The boundary conditions must be set before the simulation is added to a batch!") );
+  }
+  if ( sim.getSource()->getDim() != ParaxialSource::Dim_t::TWO_D )
+  {
+    throw( runtime_error("Only 2D sources can be used in a batch!") );
+  }
+
+  const Solver2D *solver = dynamic_cast<const Solver2D*>( &sim.getSolver() );
+  if ( solver == nullptr )
+  {
+    throw( runtime_error("The simulations in a batch must have a 2D solver!") );
+  }
+  if ( typeid( solver->getEquation() ) != typeid( ParaxialEquation ) )
+  {
+    throw( runtime_error("BatchedCrankNicholson only solves the Cartesian paraxial equation!") );
+  }
+
+  if ( !members.empty() )
+  {
+    verifyGrid( sim );
+  }
+
+  Member member;
+  member.sim = &sim;
+  member.sweepValue = sweepValue;
+  members.push_back( member );
+}
+
+void BatchedCrankNicholson::verifyGrid( const ParaxialSimulation &sim ) const
+{
+  const ParaxialSimulation &first = *members[0].sim;
+  const double tol = 1E-10;
+  bool xMatch = ( sim.nodeNumberTransverse() == first.nodeNumberTransverse() ) &&
+                ( abs( sim.transverseDiscretization().min - first.transverseDiscretization().min ) < tol ) &&
+                ( abs( sim.transverseDiscretization().step - first.transverseDiscretization().step ) < tol );
+  bool zMatch = ( sim.nodeNumberLongitudinal() == first.nodeNumberLongitudinal() ) &&
+                ( abs( sim.longitudinalDiscretization().min - first.longitudinalDiscretization().min ) < tol ) &&
+                ( abs( sim.longitudinalDiscretization().step - first.longitudinalDiscretization().step ) < tol );
+  if ( !xMatch || !zMatch )
+  {
+    throw( runtime_error("All simulations in a batch must have the same discretization!") );
+  }
+}
+
+void BatchedCrankNicholson::evaluatePlane( double z, arma::vec &deltaPlane, arma::vec &betaPlane ) const
+{
+  unsigned int M = members.size();
+  const ParaxialSimulation &first = *members[0].sim;
+  deltaPlane.set_size( M*Nx );
+  betaPlane.set_size( M*Nx );
+
+  #pragma omp parallel for schedule(static)
+  for ( unsigned int indx=0;indx<M*Nx;indx++ )
+  {
+    unsigned int m = indx/Nx;
+    double x = first.getX( indx%Nx );
+    members[m].sim->getXrayMatProp( x, z, deltaPlane[indx], betaPlane[indx] );
+  }
+}
+
+void BatchedCrankNicholson::solve()
+{
+  if ( members.empty() )
+  {
+    throw( runtime_error("No simulations added to the batch!") );
+  }
+
+  const ParaxialSimulation &first = *members[0].sim;
+  unsigned int M = members.size();
+  Nx = first.nodeNumberTransverse();
+  Nz = first.nodeNumberLongitudinal();
+  storeEvery = first.longitudinalDiscretization().downsamplingRatio;
+  if ( storeEvery == 0 ) storeEvery = 1;
+  double stepX = first.transverseDiscretization().step;
+  double stepZ = first.longitudinalDiscretization().step;
+  unsigned int nStored = ( Nz-1 )/storeEvery + 1;
+
+  // Initial conditions
+  prevField.set_size( M*Nx );
+  solutions.resize( M );
+  for ( unsigned int m=0;m<M;m++ )
+  {
+    solutions[m].set_size( Nx, nStored );
+    for ( unsigned int ix=0;ix<Nx;ix++ )
+    {
+      prevField[m*Nx+ix] = members[m].sim->getSource()->get( first.getX(ix), 0.0 );
+      solutions[m](ix,0) = prevField[m*Nx+ix];
+    }
+  }
+
+  // The coefficients that only depend on the wavenumber are shared by all nodes of a member
+  arma::vec rho( M );
+  arma::vec r( M );
+  for ( unsigned int m=0;m<M;m++ )
+  {
+    double k = members[m].sim->getWavenumber();
+    rho[m] = stepZ/( k*stepX*stepX );
+    r[m] = k*stepZ;
+  }
+
+  workspace.reserve( 3*Workspace::bytes<cdouble>(M*Nx) );
+  cdouble *diag = workspace.allocate<cdouble>(M*Nx);
+  cdouble *subdiag = workspace.allocate<cdouble>(M*Nx);
+  cdouble *rhs = workspace.allocate<cdouble>(M*Nx);
+  matrixSolver.reserve( Nx );
+  cdouble im(0.0,1.0);
+
+  evaluatePlane( first.getZ(0), deltaPrev, betaPrev );
+  for ( unsigned int iz=1;iz<Nz;iz++ )
+  {
+    evaluatePlane( first.getZ(iz), delta, beta );
+
+    #pragma omp parallel for schedule(static)
+    for ( unsigned int indx=0;indx<M*Nx;indx++ )
+    {
+      unsigned int m = indx/Nx;
+      unsigned int ix = indx%Nx;
+      cdouble iRho = 0.25*im*rho[m];
+
+      // The last element of each subdiagonal is not used by the batched solver
+      subdiag[indx] = -iRho;
+      diag[indx] = 1.0 + 2.0*iRho + 0.5*r[m]*( beta[indx] + im*delta[indx] );
+
+      cdouble left = ( ix > 0 ) ? prevField[indx-1]:0.0;
+      cdouble center = prevField[indx];
+      cdouble right = ( ix < Nx-1 ) ? prevField[indx+1]:0.0;
+      rhs[indx] = iRho*( left + right - 2.0*center ) + ( 1.0 - 0.5*r[m]*( betaPrev[indx] + im*deltaPrev[indx] ) )*center;
+    }
+
+    if ( transparentBC )
+    {
+      for ( unsigned int m=0;m<M;m++ )
+      {
+        applyTBCOneSide( m, diag, rhs, 0, 1, rho[m] );
+        applyTBCOneSide( m, diag, rhs, Nx-1, Nx-2, rho[m] );
+      }
+    }
+
+    matrixSolver.solveBatch( diag, subdiag, rhs, Nx, M );
+
+    #pragma omp parallel for schedule(static)
+    for ( unsigned int indx=0;indx<M*Nx;indx++ )
+    {
+      prevField[indx] = diag[indx];
+    }
+
+    if ( iz%storeEvery == 0 )
+    {
+      for ( unsigned int m=0;m<M;m++ )
+      {
+        solutions[m].col( iz/storeEvery ) = prevField.subvec( m*Nx, (m+1)*Nx-1 );
+      }
+    }
+
+    deltaPrev.swap( delta );
+    betaPrev.swap( beta );
+  }
+}
+
+void BatchedCrankNicholson::applyTBCOneSide( unsigned int m, cdouble diag[], cdouble rhs[], unsigned int outer, unsigned int inner, double rho ) const
+{
+  const double ZERO = 1E-16;
+  unsigned int start = m*Nx;
+  if ( abs( prevField[start+inner] ) <= ZERO ) return;
+
+  cdouble im(0.0,1.0);
+  cdouble kdx = log( prevField[start+outer]/prevField[start+inner] )/im;
+  if ( kdx.real() < 0.0 )
+  {
+    kdx.real(0.0);
+  }
+  diag[start+outer] -= 0.25*im*rho*exp(im*kdx);
+  rhs[start+outer] += 0.25*im*rho*exp(im*kdx)*prevField[start+outer];
+}
+
+void BatchedCrankNicholson::save( const string &fname ) const
+{
+  if ( solutions.empty() )
+  {
+    throw( runtime_error("The batch has not been solved!") );
+  }
+
+  unsigned int M = solutions.size();
+  unsigned int nStored = solutions[0].n_cols;
+
+  // Column major (x,z,sweep) is stored as (sweep,z,x) in HDF5
+  arma::cube amplitude( Nx, nStored, M );
+  arma::cube phase( Nx, nStored, M );
+  arma::vec sweep( M );
+  for ( unsigned int m=0;m<M;m++ )
+  {
+    amplitude.slice(m) = arma::abs( solutions[m] );
+    phase.slice(m) = arma::arg( solutions[m] );
+    sweep[m] = members[m].sweepValue;
+  }
+
+  const ParaxialSimulation &first = *members[0].sim;
+  H5::H5File file( fname.c_str(), H5F_ACC_TRUNC );
+  hsize_t cubeDims[3] = {M, nStored, Nx};
+  H5::DataSpace cubeSpace( 3, cubeDims );
+  H5::DataSet ampSet = file.createDataSet( "amplitude", H5::PredType::NATIVE_DOUBLE, cubeSpace );
+  ampSet.write( amplitude.memptr(), H5::PredType::NATIVE_DOUBLE );
+  H5::DataSet phaseSet = file.createDataSet( "phase", H5::PredType::NATIVE_DOUBLE, cubeSpace );
+  phaseSet.write( phase.memptr(), H5::PredType::NATIVE_DOUBLE );
+
+  hsize_t sweepDims[1] = {M};
+  H5::DataSpace sweepSpace( 1, sweepDims );
+  H5::DataSet sweepSet = file.createDataSet( "sweep", H5::PredType::NATIVE_DOUBLE, sweepSpace );
+  sweepSet.write( sweep.memptr(), H5::PredType::NATIVE_DOUBLE );
+
+  H5::DataSpace attribSpace( H5S_SCALAR );
+  H5::StrType strType( H5::PredType::C_S1, sweepName.size()+1 );
+  H5::Attribute nameAttr = sweepSet.createAttribute( "parameter", strType, attribSpace );
+  nameAttr.write( strType, sweepName.c_str() );
+
+  double limits[4] = {first.transverseDiscretization().min, first.getX(Nx-1), first.getZ(0), first.getZ(Nz-1)};
+  const char* names[4] = {"xmin", "xmax", "zmin", "zmax"};
+  for ( unsigned int i=0;i<4;i++ )
+  {
+    H5::Attribute att = ampSet.createAttribute( names[i], H5::PredType::NATIVE_DOUBLE, attribSpace );
+    att.write( H5::PredType::NATIVE_DOUBLE, &limits[i] );
+  }
+  clog << "Batch of " << M << " simulations written to " << fname << endl;
+}
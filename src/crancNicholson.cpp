@@ -6,6 +6,8 @@
 #include "paraxialEquation.hpp"
 #include <cassert>
 #include "boundaryCondition.hpp"
+#include "equationPolicy.hpp"
+#include <typeinfo>
 
 using namespace std;
 
@@ -17,91 +19,152 @@ CrankNicholson::~CrankNicholson(){};
 void CrankNicholson::solveStep( unsigned int iz )
 {
   assert( iz>=1 );
-  cdouble *subdiag = new cdouble[Nx-1];
-  cdouble *rhs = new cdouble[Nx];
-  cdouble *diag = new cdouble[Nx];
+  workspace.reserve( workspaceBytes(Nx) );
+  cdouble *subdiag = workspace.allocate<cdouble>(Nx-1);
+  cdouble *rhs = workspace.allocate<cdouble>(Nx);
+  cdouble *diag = workspace.allocate<cdouble>(Nx);
 
   // Two useful dimensionless numbers
   rho = stepZ/(wavenumber*stepX*stepX);
   double r = wavenumber*stepZ;
 
-  double z = zmin + static_cast<double>(iz)*stepZ;
+  double z = stepStartZ + stepZ;
+  updatePlanes( z, iz==1 );
+  const CoefficientPlane &cur = *currentPlane;
+  const CoefficientPlane &prev = *prevPlane;
 
-  for ( unsigned int ix=0; ix<Nx; ix++ )
+  // Each row is independent, so the assembly is distributed among the threads. Small systems are assembled serially
+  // The field is zero outside the domain, the transparent boundary conditions are applied afterwards
+  const cdouble *field = prevSolution->memptr();
+  const cdouble iRho = 0.25*IMAG_UNIT*rho;
+  #pragma omp parallel if ( Nx >= MIN_NODES_PARALLEL_ASSEMBLY )
   {
-    double x = guide->getX( ix );
-    double xPrevShifted = x;
-    double xShifted = x;
-
-    double delta, beta;
-    double deltaPrev, betaPrev;
-    guide->getXrayMatProp( xShifted, z, delta, beta );
-    guide->getXrayMatProp( xPrevShifted, z-stepZ, deltaPrev, betaPrev);
-
-    Hpluss = eq->H(xShifted+0.5*stepX,z);
-    Hminus = eq->H(xShifted-0.5*stepX,z);
-    gval = eq->G(xShifted,z);
-    double fval = eq->F(xShifted,z);
-    double jval = eq->J(xShifted,z);
-    double jvalPrev = eq->J(xPrevShifted,z-stepZ);
-    delta -= jval;
-    deltaPrev -= jvalPrev;
-
-    diag[ix] = fval*1.0 + 0.25*( Hpluss+Hminus )*gval*IMAG_UNIT*rho + 0.5*(beta*r + IMAG_UNIT*delta*r);
-
-    if ( ix < Nx-1 )
+    #pragma omp for schedule(static) nowait
+    for ( unsigned int ix=0; ix<Nx-1; ix++ )
     {
-      subdiag[ix] = -0.25*IMAG_UNIT*rho*Hminus*gval;
+      subdiag[ix] = -iRho*cur.Hminus[ix]*cur.G[ix];
     }
 
-    HplussPrev = eq->H(xPrevShifted+0.5*stepX,z-stepZ);
-    HminusPrev = eq->H(xPrevShifted-0.5*stepX,z-stepZ);
-    gvalPrev = eq->G(xPrevShifted,z-stepZ);
-    double fvalPrev = eq->F(xPrevShifted,z-stepZ);
-
-    // Fill right hand side
-    cdouble left, center, right;
-
-    if ( ix > 0 )
-    {
-      left = (*prevSolution)(ix-1);
-    }
-    else
-    {
-      left = 0.0;
-    }
-    center = (*prevSolution)(ix);
-    if ( ix < Nx-1 )
+    #pragma omp for schedule(static)
+    for ( unsigned int ix=0; ix<Nx; ix++ )
     {
-      right = (*prevSolution)(ix+1);
-    }
-    else
-    {
-      right = 0.0;
-    }
+      diag[ix] = cur.F[ix] + iRho*( cur.Hpluss[ix]+cur.Hminus[ix] )*cur.G[ix] + 0.5*(cur.beta[ix]*r + IMAG_UNIT*cur.delta[ix]*r);
 
-    rhs[ix] = left*HminusPrev*gvalPrev;
-    rhs[ix] += right*HplussPrev*gvalPrev;
+      // Fill right hand side
+      cdouble left = ( ix > 0 ) ? field[ix-1]:0.0;
+      cdouble center = field[ix];
+      cdouble right = ( ix < Nx-1 ) ? field[ix+1]:0.0;
 
-    rhs[ix] *=  (0.25*IMAG_UNIT*rho);
-    rhs[ix] -= 0.25*center*IMAG_UNIT*rho*(HplussPrev+HminusPrev)*gval;
-    rhs[ix] += (1.0*fvalPrev - 0.5*(betaPrev*r + IMAG_UNIT*deltaPrev*r) )*center;
+      rhs[ix] = iRho*( left*prev.Hminus[ix] + right*prev.Hpluss[ix] )*prev.G[ix];
+      rhs[ix] -= iRho*center*(prev.Hpluss[ix]+prev.Hminus[ix])*cur.G[ix];
+      rhs[ix] += (1.0*prev.F[ix] - 0.5*(prev.beta[ix]*r + IMAG_UNIT*prev.delta[ix]*r) )*center;
+    }
   }
 
   applyBC( subdiag, diag, rhs );
 
-  // Solve the tridiagonal system
-  matrixSolver.solve( diag, subdiag, rhs, Nx);
+  // Solve the tridiagonal system. Very wide systems are split among the threads
+  matrixSolver.solvePartitioned( diag, subdiag, rhs, Nx );
 
   // Copy solution to matrix
+  #pragma omp parallel for if ( Nx >= MIN_NODES_PARALLEL_ASSEMBLY )
   for ( unsigned int ix=0;ix<Nx;ix++ )
   {
     (*currentSolution)(ix) = diag[ix];
   }
+}
 
-  delete [] rhs;
-  delete [] subdiag;
-  delete [] diag;
+void CrankNicholson::setSimulator( ParaxialSimulation &newGuide )
+{
+  Solver2D::setSimulator( newGuide );
+  workspace.reserve( workspaceBytes( guide->nodeNumberTransverse() ) );
+}
+
+size_t CrankNicholson::workspaceBytes( unsigned int nNodes )
+{
+  return 2*Workspace::bytes<cdouble>(nNodes) + Workspace::bytes<cdouble>(nNodes-1);
+}
+
+void CrankNicholson::evaluatePlane( double z, CoefficientPlane &plane ) const
+{
+  // The built in equations are inlined, user defined equations use virtual calls
+  const ConformalEquation *conformal = dynamic_cast<const ConformalEquation*>( eq );
+  if ( typeid(*eq) == typeid(ParaxialEquation) )
+  {
+    fillPlane( eqpolicy::Cartesian(), z, plane );
+  }
+  else if ( conformal != nullptr )
+  {
+    fillPlane( eqpolicy::Conformal( conformal->getRadiusOfCurvature() ), z, plane );
+  }
+  else
+  {
+    fillPlane( eqpolicy::Virtual( *eq ), z, plane );
+  }
+}
+
+template<class Eq>
+void CrankNicholson::fillPlane( const Eq &equation, double z, CoefficientPlane &plane ) const
+{
+  plane.delta.set_size( Nx );
+  plane.beta.set_size( Nx );
+  plane.F.set_size( Nx );
+  plane.G.set_size( Nx );
+  plane.Hpluss.set_size( Nx );
+  plane.Hminus.set_size( Nx );
+
+  // The material and equation are only read, so the nodes can be evaluated concurrently
+  #pragma omp parallel for if ( Nx >= MIN_NODES_PARALLEL_ASSEMBLY )
+  for ( unsigned int ix=0;ix<Nx;ix++ )
+  {
+    double x = guide->getX( ix );
+    guide->getXrayMatProp( x, z, plane.delta[ix], plane.beta[ix] );
+    plane.delta[ix] -= equation.J(x,z);
+    plane.F[ix] = equation.F(x,z);
+    plane.G[ix] = equation.G(x,z);
+    plane.Hpluss[ix] = equation.H(x+0.5*stepX,z);
+    plane.Hminus[ix] = equation.H(x-0.5*stepX,z);
+  }
+  plane.z = z;
+  plane.isValid = true;
+}
+
+bool CrankNicholson::coefficientsAreZIndependent() const
+{
+  return eq->isZIndependent() && guide->materialIsZIndependent();
+}
+
+void CrankNicholson::updatePlanes( double z, bool firstStep )
+{
+  if ( firstStep )
+  {
+    // The material or the equation may have changed since the last run
+    planes[0].isValid = false;
+    planes[1].isValid = false;
+  }
+
+  if ( coefficientsAreZIndependent() )
+  {
+    // One table serves as both planes for the entire run
+    if ( !planes[0].isValid || ( planes[0].delta.n_elem != Nx ) )
+    {
+      evaluatePlane( z, planes[0] );
+    }
+    prevPlane = &planes[0];
+    currentPlane = &planes[0];
+    return;
+  }
+
+  prevPlane = currentPlane;
+  currentPlane = ( prevPlane == &planes[0] ) ? &planes[1]:&planes[0];
+
+  // The previous plane was evaluated in the last step unless this is the first step
+  const double zTol = 1E-6*stepZ;
+  if ( !prevPlane->isValid || ( abs(prevPlane->z-(z-stepZ)) > zTol ) || ( prevPlane->delta.n_elem != Nx ) )
+  {
+    evaluatePlane( z-stepZ, *prevPlane );
+  }
+  evaluatePlane( z, *currentPlane );
 }
 
 void CrankNicholson::applyBC( cdouble subdiag[], cdouble diag[], cdouble rhs[] )
@@ -143,6 +206,6 @@ void CrankNicholson::applyTBCOneSide( cdouble subdiag[], cdouble diag[], cdouble
     kdx.real(0.0);
   }
 
-  diag[outer] -= 0.25*im*rho*Hminus*gval*exp(im*kdx);
-  rhs[outer] += 0.25*im*rho*HminusPrev*gvalPrev*exp(im*kdx)*getLastSolution()(outer);
+  diag[outer] -= 0.25*im*rho*currentPlane->Hminus[outer]*currentPlane->G[outer]*exp(im*kdx);
+  rhs[outer] += 0.25*im*rho*prevPlane->Hminus[outer]*prevPlane->G[outer]*exp(im*kdx)*getLastSolution()(outer);
 }
@@ -13,6 +13,8 @@ using namespace std;
 typedef complex<double> cdouble;
 
 const double PI = acos(-1.0);
+const unsigned int FFT_BATCH_SIZE = 64;
+
 void post::FarField::setAngleRange( double angMin, double angMax )
 {
   phiMin = angMin;
@@ -50,7 +52,8 @@ void post::FarField::result( const Solver &solver, arma::vec &res )
     }
   }
 
-  arma::cx_vec ft = arma::fft( paddedSignal );
+  arma::cx_vec ft = paddedSignal;
+  plans.execute1D( ft.memptr(), ft.memptr(), ft.n_elem, FFTW_FORWARD );
 
   res = arma::abs(ft)/sqrt(ft.n_elem);
 
@@ -141,22 +144,19 @@ void post::FarField::addAttrib( vector<H5Attr> &attr ) const
 void post::FarField::result( const Solver &solver, arma::mat &res )
 {
   arma::cx_mat solution = solver.getLastSolution3D();
+  if ( sim != NULL )
+  {
+    plans.setNumberOfThreads( sim->getNumberOfThreads() );
+  }
 
-  // Increase the pad length to at least the range of the solution
-  signalLength = signalLength < solution.n_rows ? solution.n_rows:signalLength;
-  signalLength = signalLength < solution.n_cols ? solution.n_cols:signalLength;
-
-  unsigned int Nx = signalLength < res.n_rows ? res.n_rows:signalLength;
-  unsigned int Ny = signalLength < res.n_cols ? res.n_cols:signalLength;
-
-  assert( Nx == Ny ); // TODO: Currently only square matrix is supported
+  // The pad length is increased to at least the range of the solution in each direction
+  unsigned int padLengthY = signalLength < solution.n_rows ? solution.n_rows:signalLength;
+  unsigned int padLengthX = signalLength < solution.n_cols ? solution.n_cols:signalLength;
 
   // Perform FFT over columns
-  arma::cx_vec pad( Nx );
-  arma::cx_vec ft( Nx );
-  pad.fill(0.0);
-  unsigned int indxMin = farFieldAngleToIndx( phiMin, pad.n_elem, Dir_t::Y );
-  unsigned int indxMax = farFieldAngleToIndx( phiMax, pad.n_elem, Dir_t::Y );
+  arma::cx_vec ft( padLengthY );
+  unsigned int indxMin = farFieldAngleToIndx( phiMin, padLengthY, Dir_t::Y );
+  unsigned int indxMax = farFieldAngleToIndx( phiMax, padLengthY, Dir_t::Y );
   assert( indxMax >= indxMin );
 
   unsigned int nrows = indxMax-indxMin+1;
@@ -170,7 +170,7 @@ void post::FarField::result( const Solver &solver, arma::mat &res )
     cout << "The requested far field size is zero!\n";
     return;
   }
-  else if ( nrows == pad.n_elem )
+  else if ( nrows == padLengthY )
   {
     cout << "Warning! The requested scattering angle is beyond the maximum limit! Increase the resolution!\n";
   }
@@ -186,34 +186,36 @@ void post::FarField::result( const Solver &solver, arma::mat &res )
   arma::cx_mat temporary(nrows, solution.n_cols );
   temporary.fill( 0.0 );
 
-  fftw_complex* data = reinterpret_cast<fftw_complex*>( pad.memptr() );
-
-  // TODO: If mysterious seg. faults occure, check if the pad signal needs to have to extra elements when performing in-place transform
-  fftw_plan plan = fftw_plan_dft_1d( pad.n_elem, data, data, FFTW_FORWARD, FFTW_ESTIMATE );
-
   #ifdef DEBUG_FARFIELD_POST
     clog << "Perform FFT over columns...\n";
   #endif
 
-  // FFT over columns
-  for ( unsigned int i=0;i<solution.n_cols;i++ )
+  // FFT over columns. The columns are transformed in batches such that FFTW can distribute the work over threads
+  arma::cx_mat batch( padLengthY, FFT_BATCH_SIZE );
+  for ( unsigned int start=0;start<solution.n_cols;start+=FFT_BATCH_SIZE )
   {
-    pad.subvec( 0, solution.n_rows-1 ) = solution.col(i);
-    padSignal( pad );
-    fftw_execute( plan );
-    ft = pad; // Perform copy to avoid changing the FFTW plan
-    fftshift( ft );
-    reduceArray( ft, Dir_t::Y );
-    //temporary.insert_cols(i, ft);
-    temporary.col(i) = ft;
-    pad.fill(0.0);
+    unsigned int nInBatch = start+FFT_BATCH_SIZE < solution.n_cols ? FFT_BATCH_SIZE:solution.n_cols-start;
+    batch.fill(0.0);
+    for ( unsigned int j=0;j<nInBatch;j++ )
+    {
+      arma::cx_vec column( batch.colptr(j), padLengthY, false, true );
+      column.subvec( 0, solution.n_rows-1 ) = solution.col(start+j);
+      padSignal( column );
+    }
+    plans.executeMany1D( batch.memptr(), padLengthY, FFT_BATCH_SIZE, FFTW_FORWARD );
+
+    for ( unsigned int j=0;j<nInBatch;j++ )
+    {
+      ft = batch.col(j);
+      fftshift( ft );
+      reduceArray( ft, Dir_t::Y );
+      temporary.col(start+j) = ft;
+    }
   }
 
   // FFT over rows
-  pad.set_size( Ny );
-  pad.fill( 0.0 );
-  indxMin = farFieldAngleToIndx( phiMin, pad.n_elem, Dir_t::X );
-  indxMax = farFieldAngleToIndx( phiMax, pad.n_elem, Dir_t::X );
+  indxMin = farFieldAngleToIndx( phiMin, padLengthX, Dir_t::X );
+  indxMax = farFieldAngleToIndx( phiMax, padLengthX, Dir_t::X );
   assert( indxMax >= indxMin );
 
   unsigned int ncols = indxMax-indxMin+1;
@@ -222,19 +224,28 @@ void post::FarField::result( const Solver &solver, arma::mat &res )
   #ifdef DEBUG_FARFIELD_POST
     clog << "Compute FFT over rows...\n";
   #endif
-  for ( unsigned int i=0;i<temporary.n_rows;i++ )
+  batch.set_size( padLengthX, FFT_BATCH_SIZE );
+  double normalization = sqrt( static_cast<double>(padLengthX)*padLengthY );
+  for ( unsigned int start=0;start<temporary.n_rows;start+=FFT_BATCH_SIZE )
   {
-    pad.subvec( 0, temporary.n_cols-1 ) = temporary.row(i).t();
-    padSignal( pad );
-    fftw_execute( plan );
-    ft = pad; // Copy to not change the FFTW plan
-    fftshift( ft );
-    reduceArray( ft, Dir_t::X );
-    //res.insert_rows( i, arma::pow( arma::abs( ft ), 2 ).t() );
-    res.row(i) = arma::pow( arma::abs( ft ), 2 ).t()/signalLength;
-    pad.fill(0.0);
+    unsigned int nInBatch = start+FFT_BATCH_SIZE < temporary.n_rows ? FFT_BATCH_SIZE:temporary.n_rows-start;
+    batch.fill(0.0);
+    for ( unsigned int j=0;j<nInBatch;j++ )
+    {
+      arma::cx_vec row( batch.colptr(j), padLengthX, false, true );
+      row.subvec( 0, temporary.n_cols-1 ) = temporary.row(start+j).t();
+      padSignal( row );
+    }
+    plans.executeMany1D( batch.memptr(), padLengthX, FFT_BATCH_SIZE, FFTW_FORWARD );
+
+    for ( unsigned int j=0;j<nInBatch;j++ )
+    {
+      ft = batch.col(j);
+      fftshift( ft );
+      reduceArray( ft, Dir_t::X );
+      res.row(start+j) = arma::pow( arma::abs( ft ), 2 ).t()/normalization;
+    }
   }
-  fftw_destroy_plan( plan );
 
   if ( resizeMatrices )
   {
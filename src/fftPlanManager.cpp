@@ -0,0 +1,328 @@
+#include "fftPlanManager.hpp"
+#include <stdexcept>
+#include <iostream>
+#include <omp.h>
+
+using namespace std;
+
+string FFTPlanManager::pendingSingleWisdomFile{""};
+bool FFTPlanManager::singlePlansCreated{false};
+
+FFTPlanManager::~FFTPlanManager()
+{
+  clear();
+}
+
+void FFTPlanManager::setRigor( PlanRigor_t newRigor )
+{
+  if ( newRigor == rigor ) return;
+  clear();
+  rigor = newRigor;
+}
+
+void FFTPlanManager::clear()
+{
+  // Only the execution of plans is thread safe in FFTW
+  #pragma omp critical(fftwPlanner)
+  {
+    for ( unsigned int i=0;i<plans.size();i++ )
+    {
+      if ( plans[i].plan != NULL ) fftw_destroy_plan( plans[i].plan );
+      if ( plans[i].planf != NULL ) fftwf_destroy_plan( plans[i].planf );
+    }
+  }
+  plans.clear();
+}
+
+FFTPlanManager::PlanKey FFTPlanManager::key1D( unsigned int N, unsigned int howmany, int sign )
+{
+  PlanKey key;
+  key.rank = 1;
+  key.n0 = N;
+  key.n1 = 1;
+  key.howmany = howmany;
+  key.sign = sign;
+  return key;
+}
+
+FFTPlanManager::PlanKey FFTPlanManager::key2D( unsigned int nrows, unsigned int ncols, int sign )
+{
+  // NOTE: FFTW assumes row-major ordering, while Armadillo uses column major
+  PlanKey key;
+  key.rank = 2;
+  key.n0 = ncols;
+  key.n1 = nrows;
+  key.sign = sign;
+  return key;
+}
+
+void FFTPlanManager::execute1D( cdouble *in, cdouble *out, unsigned int N, int sign )
+{
+  PlanKey key = key1D( N, 1, sign );
+  execute( key, in, out );
+}
+
+void FFTPlanManager::executeMany1D( cdouble *data, unsigned int N, unsigned int howmany, int sign )
+{
+  PlanKey key = key1D( N, howmany, sign );
+  execute( key, data, data );
+}
+
+void FFTPlanManager::execute2D( cdouble *in, cdouble *out, unsigned int nrows, unsigned int ncols, int sign )
+{
+  PlanKey key = key2D( nrows, ncols, sign );
+  execute( key, in, out );
+}
+
+void FFTPlanManager::execute1D( cfloat *in, cfloat *out, unsigned int N, int sign )
+{
+  PlanKey key = key1D( N, 1, sign );
+  execute( key, in, out );
+}
+
+void FFTPlanManager::executeMany1D( cfloat *data, unsigned int N, unsigned int howmany, int sign )
+{
+  PlanKey key = key1D( N, howmany, sign );
+  execute( key, data, data );
+}
+
+void FFTPlanManager::execute2D( cfloat *in, cfloat *out, unsigned int nrows, unsigned int ncols, int sign )
+{
+  PlanKey key = key2D( nrows, ncols, sign );
+  execute( key, in, out );
+}
+
+void FFTPlanManager::execute( PlanKey &key, cdouble *in, cdouble *out )
+{
+  fftw_complex *fin = reinterpret_cast<fftw_complex*>( in );
+  fftw_complex *fout = reinterpret_cast<fftw_complex*>( out );
+  key.inPlace = ( in == out );
+  key.nThreads = getNumberOfThreads();
+  key.singlePrecision = false;
+
+  // Plans are created on arrays allocated by FFTW. If the arrays are not aligned
+  // in the same way, an unaligned plan is needed
+  key.unaligned = ( fftw_alignment_of( reinterpret_cast<double*>(in) ) != 0 ) ||
+                  ( fftw_alignment_of( reinterpret_cast<double*>(out) ) != 0 );
+  fftw_execute_dft( getPlan( key ).plan, fin, fout );
+}
+
+void FFTPlanManager::execute( PlanKey &key, cfloat *in, cfloat *out )
+{
+  fftwf_complex *fin = reinterpret_cast<fftwf_complex*>( in );
+  fftwf_complex *fout = reinterpret_cast<fftwf_complex*>( out );
+  key.inPlace = ( in == out );
+  key.nThreads = getNumberOfThreads();
+  key.singlePrecision = true;
+  key.unaligned = ( fftwf_alignment_of( reinterpret_cast<float*>(in) ) != 0 ) ||
+                  ( fftwf_alignment_of( reinterpret_cast<float*>(out) ) != 0 );
+  fftwf_execute_dft( getPlan( key ).planf, fin, fout );
+}
+
+const FFTPlanManager::StoredPlan& FFTPlanManager::getPlan( const PlanKey &key )
+{
+  for ( unsigned int i=0;i<plans.size();i++ )
+  {
+    const PlanKey &stored = plans[i].key;
+    if (( stored.rank == key.rank ) && ( stored.n0 == key.n0 ) && ( stored.n1 == key.n1 ) &&
+        ( stored.howmany == key.howmany ) && ( stored.sign == key.sign ) && ( stored.nThreads == key.nThreads ) &&
+        ( stored.inPlace == key.inPlace ) && ( stored.unaligned == key.unaligned ) &&
+        ( stored.singlePrecision == key.singlePrecision ))
+    {
+      return plans[i];
+    }
+  }
+
+  initThreads();
+  StoredPlan newPlan;
+  newPlan.key = key;
+
+  // The FFTW planner is not thread safe, which matters when several simulations run concurrently
+  #pragma omp critical(fftwPlanner)
+  {
+    if ( key.singlePrecision )
+    {
+      importPendingSingleWisdom();
+      newPlan.planf = createPlanSingle( key );
+      singlePlansCreated = singlePlansCreated || ( newPlan.planf != NULL );
+    }
+    else
+    {
+      newPlan.plan = createPlan( key );
+    }
+  }
+  if ( !key.singlePrecision && ( newPlan.plan == NULL ))
+  {
+    throw( runtime_error("FFTW could not create a plan!") );
+  }
+  else if ( key.singlePrecision && ( newPlan.planf == NULL ))
+  {
+    throw( runtime_error("FFTW could not create a single precision plan!") );
+  }
+  plans.push_back( newPlan );
+  return plans.back();
+}
+
+fftw_plan FFTPlanManager::createPlan( const PlanKey &key ) const
+{
+  fftw_plan_with_nthreads( key.nThreads );
+
+  unsigned int N = key.n0*key.n1*key.howmany;
+  fftw_complex *in = fftw_alloc_complex( N );
+  fftw_complex *out = key.inPlace ? in:fftw_alloc_complex( N );
+
+  unsigned int flags = rigorFlag();
+  if ( key.unaligned ) flags |= FFTW_UNALIGNED;
+
+  fftw_plan plan;
+  if (( key.rank == 1 ) && ( key.howmany > 1 ))
+  {
+    plan = fftw_plan_many_dft( 1, &key.n0, key.howmany, in, NULL, 1, key.n0, out, NULL, 1, key.n0, key.sign, flags );
+  }
+  else if ( key.rank == 1 )
+  {
+    plan = fftw_plan_dft_1d( key.n0, in, out, key.sign, flags );
+  }
+  else
+  {
+    plan = fftw_plan_dft_2d( key.n0, key.n1, in, out, key.sign, flags );
+  }
+
+  if ( !key.inPlace ) fftw_free( out );
+  fftw_free( in );
+
+  return plan;
+}
+
+fftwf_plan FFTPlanManager::createPlanSingle( const PlanKey &key ) const
+{
+  fftwf_plan_with_nthreads( key.nThreads );
+
+  unsigned int N = key.n0*key.n1*key.howmany;
+  fftwf_complex *in = fftwf_alloc_complex( N );
+  fftwf_complex *out = key.inPlace ? in:fftwf_alloc_complex( N );
+
+  unsigned int flags = rigorFlag();
+  if ( key.unaligned ) flags |= FFTW_UNALIGNED;
+
+  fftwf_plan plan;
+  if (( key.rank == 1 ) && ( key.howmany > 1 ))
+  {
+    plan = fftwf_plan_many_dft( 1, &key.n0, key.howmany, in, NULL, 1, key.n0, out, NULL, 1, key.n0, key.sign, flags );
+  }
+  else if ( key.rank == 1 )
+  {
+    plan = fftwf_plan_dft_1d( key.n0, in, out, key.sign, flags );
+  }
+  else
+  {
+    plan = fftwf_plan_dft_2d( key.n0, key.n1, in, out, key.sign, flags );
+  }
+
+  if ( !key.inPlace ) fftwf_free( out );
+  fftwf_free( in );
+
+  return plan;
+}
+
+unsigned int FFTPlanManager::getNumberOfThreads() const
+{
+  if ( numberOfThreads == 0 )
+  {
+    return omp_get_max_threads();
+  }
+  return numberOfThreads;
+}
+
+void FFTPlanManager::initThreads()
+{
+  static bool threadsInitialized = false;
+  bool success = true;
+  #pragma omp critical(fftwPlanner)
+  {
+    if ( !threadsInitialized )
+    {
+      success = ( fftw_init_threads() != 0 ) && ( fftwf_init_threads() != 0 );
+      threadsInitialized = success;
+    }
+  }
+
+  if ( !success )
+  {
+    throw( runtime_error("Could not initialize the threaded version of FFTW!") );
+  }
+}
+
+unsigned int FFTPlanManager::rigorFlag() const
+{
+  switch ( rigor )
+  {
+    case PlanRigor_t::ESTIMATE:
+      return FFTW_ESTIMATE;
+    case PlanRigor_t::MEASURE:
+      return FFTW_MEASURE;
+    case PlanRigor_t::PATIENT:
+      return FFTW_PATIENT;
+  }
+  return FFTW_ESTIMATE;
+}
+
+string FFTPlanManager::singlePrecisionWisdomFile( const string &fname )
+{
+  return fname+".single";
+}
+
+bool FFTPlanManager::loadWisdom( const string &fname )
+{
+  // The wisdom is part of the global planner state
+  bool success = false;
+  #pragma omp critical(fftwPlanner)
+  {
+    success = ( fftw_import_wisdom_from_filename( fname.c_str() ) != 0 );
+
+    // Most simulations run in double precision, so the single precision wisdom is only needed if such plans are created
+    pendingSingleWisdomFile = singlePrecisionWisdomFile( fname );
+  }
+
+  if ( !success )
+  {
+    clog << "Warning! Could not import FFTW wisdom from " << fname << endl;
+  }
+  return success;
+}
+
+void FFTPlanManager::importPendingSingleWisdom()
+{
+  if ( pendingSingleWisdomFile.empty() ) return;
+
+  if ( fftwf_import_wisdom_from_filename( pendingSingleWisdomFile.c_str() ) == 0 )
+  {
+    clog << "Warning! Could not import single precision FFTW wisdom from " << pendingSingleWisdomFile << endl;
+  }
+  pendingSingleWisdomFile = "";
+}
+
+bool FFTPlanManager::saveWisdom( const string &fname )
+{
+  string fnameSingle = singlePrecisionWisdomFile( fname );
+  bool successDouble = false;
+  bool successSingle = true;
+  #pragma omp critical(fftwPlanner)
+  {
+    successDouble = ( fftw_export_wisdom_to_filename( fname.c_str() ) != 0 );
+    if ( singlePlansCreated )
+    {
+      successSingle = ( fftwf_export_wisdom_to_filename( fnameSingle.c_str() ) != 0 );
+    }
+  }
+
+  if ( !successDouble )
+  {
+    clog << "Warning! Could not export FFTW wisdom to " << fname << endl;
+  }
+  if ( !successSingle )
+  {
+    clog << "Warning! Could not export single precision FFTW wisdom to " << fnameSingle << endl;
+  }
+  return successDouble && successSingle;
+}
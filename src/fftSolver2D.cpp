@@ -6,11 +6,7 @@
 using namespace std;
 const double PI = acos(-1.0);
 
-FFTSolver2D::~FFTSolver2D()
-{
-  fftw_destroy_plan( ftforw );
-  fftw_destroy_plan( ftback );
-}
+FFTSolver2D::~FFTSolver2D(){};
 
 cdouble FFTSolver2D::kernel( double kx ) const
 {
@@ -18,35 +14,69 @@ cdouble FFTSolver2D::kernel( double kx ) const
   return exp( -A*kx*kx );
 }
 
-void FFTSolver2D::propagate()
+template<class T>
+void FFTSolver2D::propagate( arma::Col< complex<T> > &field, arma::Col< complex<T> > &work )
 {
-  //*currentSolution = arma::fft( *prevSolution );
-  //clog << arma::max( arma::abs( *prevSolution) ) << endl;
-  fftw_execute( ftforw ); // FFT(prevSolution) -> currentSolution
-  for ( unsigned int i=0;i<prevSolution->n_elem; i++ )
+  unsigned int N = field.n_elem;
+  plans.execute1D( field.memptr(), work.memptr(), N, FFTW_FORWARD ); // FFT(field) -> work
+  for ( unsigned int i=0;i<N; i++ )
   {
-    double kx = spatialFreq( i, prevSolution->n_elem );
-    //(*prevSolution)[i] *= kernel( kx );
-    (*currentSolution)[i] *= kernel( kx );
+    double kx = spatialFreq( i, N );
+    work[i] *= static_cast< complex<T> >( kernel( kx ) );
   }
-  //*prevSolution = arma::ifft( *currentSolution );
-  fftw_execute( ftback ); // IFFT(currentSolution) -> prevSolution
+  plans.execute1D( work.memptr(), field.memptr(), N, FFTW_BACKWARD ); // IFFT(work) -> field
 }
 
-void FFTSolver2D::refraction( unsigned int step )
+bool FFTSolver2D::evaluateMaterial( unsigned int step )
 {
-  double z = guide->getZ( step ) + 0.5*stepZ;
-  cdouble im(0.0,1.0);
+  // The material is sampled in the middle of the step
+  double z = stepStartZ + 0.5*stepZ;
+  deltaSlice.set_size( prevSolution->n_elem );
+  betaSlice.set_size( prevSolution->n_elem );
+  bool isVacuum = true;
   for ( unsigned int i=0;i<prevSolution->n_elem; i++ )
   {
-    double delta, beta;
     double x = guide->getX(i);
-    guide->getXrayMatProp( x, z, delta, beta );
-    // FFTW3: Divide by length to normalize
-    double normalization = prevSolution->n_elem;
-    //normalization = 1.0;
-    (*currentSolution)[i] = (*prevSolution)[i]*exp( -wavenumber*(beta+im*delta)*stepZ )/normalization;
+    guide->getXrayMatProp( x, z, deltaSlice[i], betaSlice[i] );
+    isVacuum = isVacuum && ( deltaSlice[i] == 0.0 ) && ( betaSlice[i] == 0.0 );
   }
+  return isVacuum;
+}
+
+template<class T>
+void FFTSolver2D::refraction( const arma::Col< complex<T> > &field, arma::Col< complex<T> > &out )
+{
+  cdouble im(0.0,1.0);
+  // FFTW3: Divide by length to normalize
+  double normalization = field.n_elem;
+  for ( unsigned int i=0;i<field.n_elem; i++ )
+  {
+    out[i] = field[i]*static_cast< complex<T> >( exp( -wavenumber*(betaSlice[i]+im*deltaSlice[i])*stepZ )/normalization );
+  }
+}
+
+template<class T>
+void FFTSolver2D::vacuumStep( arma::Col< complex<T> > &field, arma::Col< complex<T> > &spectrum, arma::Col< complex<T> > &out )
+{
+  unsigned int N = field.n_elem;
+  if ( !gapIsOpen )
+  {
+    spectrum.set_size( N );
+    plans.execute1D( field.memptr(), spectrum.memptr(), N, FFTW_FORWARD );
+    gapDistance = 0.0;
+    gapIsOpen = true;
+  }
+  gapDistance += stepZ;
+
+  // Free space propagation is exact, so the spectrum at the start of the gap is propagated the full distance
+  cdouble A( 0.0, 0.5*gapDistance/wavenumber );
+  double normalization = N;
+  for ( unsigned int i=0;i<N;i++ )
+  {
+    double kx = spatialFreq( i, N );
+    field[i] = spectrum[i]*static_cast< complex<T> >( exp( -A*kx*kx )/normalization );
+  }
+  plans.execute1D( field.memptr(), out.memptr(), N, FFTW_BACKWARD );
 }
 
 double FFTSolver2D::spatialFreq( unsigned int indx, unsigned int size ) const
@@ -60,15 +90,81 @@ double FFTSolver2D::spatialFreq( unsigned int indx, unsigned int size ) const
 
 void FFTSolver2D::solveStep( unsigned int step )
 {
-  //planInitialized = true;
-  if ( !planInitialized )
+  if ( step == 1 ) gapIsOpen = false;
+
+  // The vacuum gap tracks the distance since the start of the gap, which does not hold when substeps are repeated
+  bool isVacuum = evaluateMaterial( step ) && !adaptive.enabled;
+
+  if ( precision == Precision_t::SINGLE )
+  {
+    // All planes are stored in 2D, so the field is converted in every step
+    fieldSingle = arma::conv_to<arma::cx_fvec>::from( *prevSolution );
+    workSingle.set_size( fieldSingle.n_elem );
+    advance( isVacuum, fieldSingle, workSingle, gapSpectrumSingle );
+    *currentSolution = arma::conv_to<arma::cx_vec>::from( workSingle );
+  }
+  else
   {
-    prev = reinterpret_cast<fftw_complex*>( prevSolution->memptr() );
-    curr = reinterpret_cast<fftw_complex*>( currentSolution->memptr() );
-    ftforw = fftw_plan_dft_1d( prevSolution->n_elem, prev, curr, FFTW_FORWARD, FFTW_ESTIMATE );
-    ftback = fftw_plan_dft_1d( prevSolution->n_elem, curr, prev, FFTW_BACKWARD, FFTW_ESTIMATE );
-    planInitialized = true;
+    advance( isVacuum, *prevSolution, *currentSolution, gapSpectrum );
   }
-  propagate();
-  refraction( step );
+}
+
+template<class T>
+void FFTSolver2D::advance( bool isVacuum, arma::Col< complex<T> > &field, arma::Col< complex<T> > &out,
+                           arma::Col< complex<T> > &spectrum )
+{
+  if ( isVacuum && vacuumSkipping )
+  {
+    vacuumStep( field, spectrum, out );
+    return;
+  }
+
+  gapIsOpen = false;
+  if ( splitting == Splitting_t::STRANG )
+  {
+    strangStep( field, out );
+    return;
+  }
+  propagate( field, out );
+  refraction( field, out );
+}
+
+template<class T>
+void FFTSolver2D::strangStep( arma::Col< complex<T> > &field, arma::Col< complex<T> > &out )
+{
+  // Every plane is stored in 2D, so both halves are applied in each step.
+  // The transmission function is evaluated once and used for both halves
+  cdouble im(0.0,1.0);
+  halfTransmission.set_size( field.n_elem );
+  for ( unsigned int i=0;i<field.n_elem;i++ )
+  {
+    halfTransmission[i] = exp( -0.5*wavenumber*(betaSlice[i]+im*deltaSlice[i])*stepZ );
+    field[i] *= static_cast< complex<T> >( halfTransmission[i] );
+  }
+
+  propagate( field, out );
+
+  // FFTW3: Divide by length to normalize
+  double normalization = field.n_elem;
+  for ( unsigned int i=0;i<field.n_elem;i++ )
+  {
+    out[i] = field[i]*static_cast< complex<T> >( halfTransmission[i]/normalization );
+  }
+}
+
+unsigned int FFTSolver2D::orderOfAccuracy() const
+{
+  return ( splitting == Splitting_t::STRANG ) ? 2:1;
+}
+
+void FFTSolver2D::reset()
+{
+  gapIsOpen = false;
+  Solver2D::reset();
+}
+
+void FFTSolver2D::setNumberOfThreads( unsigned int nThreads )
+{
+  Solver::setNumberOfThreads( nThreads );
+  plans.setNumberOfThreads( nThreads );
 }
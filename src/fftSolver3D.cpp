@@ -6,20 +6,14 @@
 #include <sstream>
 #include <omp.h>
 #include <ctime>
+#include <utility>
 //#define PRINT_TIMING_INFO
 #define UPDATE_MESSAGE_FREQUENCY 10
 using namespace std;
 
 const double PI = acos(-1.0);
 typedef visa::Colormaps::Colormap_t cmap_t;
-FFTSolver3D::~FFTSolver3D()
-{
-  if ( planInitialized )
-  {
-    fftw_destroy_plan( ftforw );
-    fftw_destroy_plan( ftback );
-  }
-}
+FFTSolver3D::~FFTSolver3D(){};
 
 cdouble FFTSolver3D::kernel( double kx, double ky ) const
 {
@@ -51,48 +45,197 @@ double FFTSolver3D::spatialFreqY( unsigned int indx, unsigned int size ) const
 
 void FFTSolver3D::solveStep( unsigned int step )
 {
-  if ( !planInitialized )
+  if ( kernelIsOutdated() )
   {
-    assert( prevSolution->is_square() );
-    assert( currentSolution->is_square() );
+    computeKernel();
+  }
 
-    prev = reinterpret_cast<fftw_complex*>( prevSolution->memptr() );
-    curr = reinterpret_cast<fftw_complex*>( currentSolution->memptr() );
-    ftforw = fftw_plan_dft_2d( prevSolution->n_rows, prevSolution->n_cols, prev, curr, FFTW_FORWARD, FFTW_ESTIMATE );
-    ftback = fftw_plan_dft_2d( prevSolution->n_rows, prevSolution->n_cols, curr, prev, FFTW_BACKWARD, FFTW_ESTIMATE );
-    planInitialized = true;
-    clog << endl; // To better for the step update
+  if ( step == 1 )
+  {
+    pendingDistance = 0.0;
+    halfRefractionPending = false;
   }
 
-  #ifdef PRINT_TIMING_INFO
-    clock_t start = clock();
-  #endif
+  updateMaterialSlices( step );
+  bool isStored = isStoredStep( step );
+  updateAbsorberProfiles();
 
-  propagate();
+  if ( precision == Precision_t::SINGLE )
+  {
+    if (( step == 1 ) || ( fieldSingle.n_rows != prevSolution->n_rows ) || ( fieldSingle.n_cols != prevSolution->n_cols ))
+    {
+      fieldSingle = arma::conv_to<arma::cx_fmat>::from( *prevSolution );
+      workSingle.set_size( prevSolution->n_rows, prevSolution->n_cols );
+    }
 
-  #ifdef PRINT_TIMING_INFO
-    clog << "Propagation step took: " << static_cast<double>( clock()-start )/CLOCKS_PER_SEC << "sec\n";
-    start = clock();
-  #endif
+    advance( step, isStored, fieldSingle, workSingle, kernelTableSingle, pendingHalfRefractionSingle );
 
-  refraction( step );
+    if ( isStored )
+    {
+      *currentSolution = arma::conv_to<arma::cx_mat>::from( fieldSingle );
+    }
+  }
+  else
+  {
+    // The field is advanced in place in prevSolution, which is also the last solution, so it is never copied.
+    // currentSolution is only used as work array
+    advance( step, isStored, *prevSolution, *currentSolution, kernelTable, pendingHalfRefraction );
+  }
 
-  #ifdef PRINT_TIMING_INFO
-    clog << "Refraction step took: " << static_cast<double>( clock()-start )/CLOCKS_PER_SEC << "sec\n";
-  #endif
+  if ( visRealSpace && (( precision == Precision_t::DOUBLE ) || isStored ))
+  {
+    const arma::cx_mat &field = ( precision == Precision_t::DOUBLE ) ? *prevSolution:*currentSolution;
+    updateVisualization( field, guide->getZ( step ) );
+  }
 
-  applyAbsorbingBC();
+  // The current slice becomes the previous slice in the next step
+  deltaPrevSlice.swap( deltaSlice );
+  betaPrevSlice.swap( betaSlice );
+  prevSliceIsVacuum = sliceIsVacuum;
+  prevSliceStep = step;
+  prevSliceIsValid = true;
 }
 
-void FFTSolver3D::propagate()
+void FFTSolver3D::step()
 {
-  // NOTE: FFTW assumes row-major ordering, while Armadillo uses column major
+  solveStep( currentStep );
+  if ( precision == Precision_t::DOUBLE )
+  {
+    storeSlice( *prevSolution, currentStep );
+  }
+  else if ( isStoredStep( currentStep ) )
+  {
+    copyCurrentSolution( currentStep );
+  }
+  currentStep++;
+}
+
+template<class T>
+void FFTSolver3D::advance( unsigned int step, bool isStored, arma::Mat< complex<T> > &field, arma::Mat< complex<T> > &work,
+                           const arma::Mat< complex<T> > &kernelTab, arma::Mat< complex<T> > &pendingHalf )
+{
+  double stepZ = guide->longitudinalDiscretization().step;
+
+  if ( prevSliceIsVacuum && sliceIsVacuum && !halfRefractionPending && canSkipVacuum() )
+  {
+    // Free space propagation is exact over any distance, so the diffraction is deferred
+    // until the field is needed
+    pendingDistance += stepZ;
+    if ( isStored )
+    {
+      propagate( field, work, kernelTab, pendingDistance );
+      pendingDistance = 0.0;
+    }
+    return;
+  }
+
+  if ( splitting == Splitting_t::STRANG )
+  {
+    strangStep( step, isStored, field, work, kernelTab, pendingHalf );
+  }
+  else
+  {
+    #ifdef PRINT_TIMING_INFO
+      clock_t start = clock();
+    #endif
 
+    propagate( field, work, kernelTab, pendingDistance+stepZ );
+    pendingDistance = 0.0;
+
+    #ifdef PRINT_TIMING_INFO
+      clog << "Propagation step took: " << static_cast<double>( clock()-start )/CLOCKS_PER_SEC << "sec\n";
+      start = clock();
+    #endif
+
+    refraction( field, step );
+
+    #ifdef PRINT_TIMING_INFO
+      clog << "Refraction step took: " << static_cast<double>( clock()-start )/CLOCKS_PER_SEC << "sec\n";
+    #endif
+  }
+}
+
+template<class T>
+void FFTSolver3D::strangStep( unsigned int step, bool isStored, arma::Mat< complex<T> > &field, arma::Mat< complex<T> > &work,
+                              const arma::Mat< complex<T> > &kernelTab, arma::Mat< complex<T> > &pendingHalf )
+{
+  // The half refraction can not be fused with the vacuum kernel, so a skipped gap is crossed first
+  if ( pendingDistance > 0.0 )
+  {
+    propagate( field, work, kernelTab, pendingDistance );
+    pendingDistance = 0.0;
+  }
+
+  if (( pendingHalf.n_rows != field.n_rows ) || ( pendingHalf.n_cols != field.n_cols ))
+  {
+    pendingHalf.set_size( field.n_rows, field.n_cols );
+  }
+
+  double z1 = guide->getZ( step );
+  double z0 = guide->getZ( step-1 );
+
+  // First half of this step fused with the second half of the previous step
+  #pragma omp parallel for
+  for ( unsigned int i=0;i<field.n_elem;i++ )
+  {
+    cdouble half = 0.5*refractionExponent( i, z0, z1 );
+    cdouble exponent = halfRefractionPending ? static_cast<cdouble>( pendingHalf[i] )+half : half;
+    field[i] *= static_cast< complex<T> >( exp( exponent ) );
+
+    // The absorber acts after the diffraction, so it is applied together with the second half
+    pendingHalf[i] = static_cast< complex<T> >( absorberIsActive ? half+absorberExponent(i):half );
+  }
+
+  propagate( field, work, kernelTab, guide->longitudinalDiscretization().step );
+
+  if ( isStored )
+  {
+    // Complete the step such that the stored field is correct
+    #pragma omp parallel for
+    for ( unsigned int i=0;i<field.n_elem;i++ )
+    {
+      field[i] *= exp( pendingHalf[i] );
+    }
+    halfRefractionPending = false;
+  }
+  else
+  {
+    // A step without material leaves nothing to complete
+    halfRefractionPending = !( prevSliceIsVacuum && sliceIsVacuum ) || absorberIsActive;
+  }
+}
+
+bool FFTSolver3D::canSkipVacuum() const
+{
+  return vacuumSkipping && !absorbX.isActive() && !absorbY.isActive() && !visRealSpace && !visFourierSpace;
+}
+
+void FFTSolver3D::updateMaterialSlices( unsigned int step )
+{
+  assert ( step > 0 );
+  double z1 = guide->getZ( step );
+  double z0 = guide->getZ( step-1 );
+
+  // The slice at z0 is the one evaluated in the previous step. Evaluate it only if that step was not the previous one
+  if ( !prevSliceIsValid || ( prevSliceStep != step-1 ) || ( deltaPrevSlice.n_rows != prevSolution->n_rows ) ||
+       ( deltaPrevSlice.n_cols != prevSolution->n_cols ) )
+  {
+    prevSliceIsVacuum = evaluateMaterialSlice( z0, deltaPrevSlice, betaPrevSlice );
+  }
+  sliceIsVacuum = evaluateMaterialSlice( z1, deltaSlice, betaSlice );
+}
+
+template<class T>
+void FFTSolver3D::propagate( arma::Mat< complex<T> > &field, arma::Mat< complex<T> > &work,
+                             const arma::Mat< complex<T> > &kernelTab, double dz )
+{
   #ifdef PRINT_TIMING_INFO
     clock_t start = clock();
   #endif
 
-  fftw_execute( ftforw ); // prev --> current
+  unsigned int nrows = field.n_rows;
+  unsigned int ncols = field.n_cols;
+  plans.execute2D( field.memptr(), work.memptr(), nrows, ncols, FFTW_FORWARD ); // field --> work
 
   #ifdef PRINT_TIMING_INFO
     clog << "FFT forward took: " << static_cast<double>(clock()-start)/CLOCKS_PER_SEC << " sec\n";
@@ -101,95 +244,154 @@ void FFTSolver3D::propagate()
   if ( visFourierSpace )
   {
     assert( plots != NULL ); // Just in case, should never happen at this stage
-    arma::mat fourierIntensity = arma::abs(*currentSolution );
+    arma::mat fourierIntensity = arma::conv_to<arma::mat>::from( arma::abs( work ) );
     plots->get("FourierIntensity").fillVertexArray( fourierIntensity );
     plots->show();
   }
 
+  if ( dz == kernelStepZ )
+  {
+    #pragma omp parallel for
+    for ( unsigned int i=0;i<work.n_elem;i++ )
+    {
+      work[i] *= kernelTab[i];
+    }
+  }
+  else
+  {
+    // Combined kernel for a run of vacuum slices
+    cdouble A(0.0, 0.5*dz/kernelWavenumber);
+    double normalization = work.n_elem;
+
+    #pragma omp parallel for
+    for ( unsigned int i=0;i<work.n_elem;i++ )
+    {
+      work[i] *= static_cast< complex<T> >( exp( -A*kSqTable[i] )/normalization );
+    }
+  }
+
+  plans.execute2D( work.memptr(), field.memptr(), nrows, ncols, FFTW_BACKWARD ); // work --> field
+}
+
+bool FFTSolver3D::kernelIsOutdated() const
+{
+  if (( kernelTable.n_rows != currentSolution->n_rows ) || ( kernelTable.n_cols != currentSolution->n_cols ))
+  {
+    return true;
+  }
+  return ( kernelStepX != guide->transverseDiscretization().step ) ||
+         ( kernelStepY != guide->verticalDiscretization().step ) ||
+         ( kernelStepZ != guide->longitudinalDiscretization().step ) ||
+         ( kernelWavenumber != guide->getWavenumber() );
+}
+
+void FFTSolver3D::computeKernel()
+{
+  kernelStepX = guide->transverseDiscretization().step;
+  kernelStepY = guide->verticalDiscretization().step;
+  kernelStepZ = guide->longitudinalDiscretization().step;
+  kernelWavenumber = guide->getWavenumber();
+  kernelTable.set_size( currentSolution->n_rows, currentSolution->n_cols );
+  kSqTable.set_size( currentSolution->n_rows, currentSolution->n_cols );
+
+  // FFTW3: Divide by length to normalize. This is done here to avoid an extra division in the refraction step
+  double normalization = kernelTable.n_rows*kernelTable.n_cols;
+
   #pragma omp parallel for
-  for ( unsigned int i=0;i<currentSolution->n_cols*currentSolution->n_rows;i++ )
+  for ( unsigned int i=0;i<kernelTable.n_elem;i++ )
+  {
+    unsigned int row = i%kernelTable.n_rows;
+    unsigned int col = i/kernelTable.n_rows;
+    double kx = spatialFreqX( col, kernelTable.n_cols );
+    double ky = spatialFreqY( row, kernelTable.n_rows );
+    kernelTable(row,col) = kernel( kx, ky )/normalization;
+    kSqTable(row,col) = kx*kx + ky*ky;
+  }
+
+  if ( precision == Precision_t::SINGLE )
   {
-    unsigned int row = i%currentSolution->n_rows;
-    unsigned int col = i/currentSolution->n_rows;
-    double kx = spatialFreqX( col, currentSolution->n_cols );
-    double ky = spatialFreqY( row, currentSolution->n_rows );
-    (*currentSolution)(row,col) *= kernel( kx, ky );
+    kernelTableSingle = arma::conv_to<arma::cx_fmat>::from( kernelTable );
   }
+}
 
-  fftw_execute( ftback ); // current --> prev
+void FFTSolver3D::setPrecision( Precision_t newPrecision )
+{
+  precision = newPrecision;
+
+  // Force the kernel tables to be recomputed
+  kernelTable.set_size( 0, 0 );
 }
 
-void FFTSolver3D::refraction( unsigned int step )
+cdouble FFTSolver3D::refractionExponent( unsigned int i, double z0, double z1 )
 {
-  assert ( step > 0 );
   double stepZ = guide->longitudinalDiscretization().step;
   double wavenumber = guide->getWavenumber();
-  double z1 = guide->getZ( step );
-  double z0 = guide->getZ( step-1 );
   cdouble im(0.0,1.0);
   const double ZERO = 1E-10;
 
-  // FFTW3: Divide by length to normalize
-  double normalization = prevSolution->n_rows*prevSolution->n_cols;
+  double delta = deltaSlice[i];
+  double beta = betaSlice[i];
+  double deltaPrev = deltaPrevSlice[i];
+  double betaPrev = betaPrevSlice[i];
 
-  #pragma omp parallel for
-  for ( unsigned int i=0;i<prevSolution->n_cols*prevSolution->n_rows; i++ )
+  if (( abs(delta-deltaPrev) > ZERO ) || ( abs(beta-betaPrev) > ZERO ))
   {
-    unsigned int row = i%prevSolution->n_rows;
-    unsigned int col = i/prevSolution->n_rows;
-
-    double x = guide->getX(col);
-    double y = guide->getY(row);
-    double delta, beta, deltaPrev, betaPrev;
-    guide->getXrayMatProp( x, y, z1, delta, beta );
-    guide->getXrayMatProp( x, y, z0, deltaPrev, betaPrev );
+      // Wave has crossed a border
+      unsigned int row = i%deltaSlice.n_rows;
+      unsigned int col = i/deltaSlice.n_rows;
+      refractionIntegral( guide->getX(col), guide->getY(row), z0, z1, deltaPrev, betaPrev, delta, beta );
+  }
+  return -wavenumber*(beta+im*delta)*stepZ;
+}
 
-    if (( abs(delta-deltaPrev) > ZERO ) || ( abs(beta-betaPrev) > ZERO ))
-    {
-        // Wave has crossed a border
-        refractionIntegral( x, y, z0, z1, delta, beta );
-    }
+template<class T>
+void FFTSolver3D::refraction( arma::Mat< complex<T> > &field, unsigned int step )
+{
+  assert ( step > 0 );
+  double z1 = guide->getZ( step );
+  double z0 = guide->getZ( step-1 );
 
-    //normalization = 1.0;
-    (*currentSolution)(row,col) = (*prevSolution)(row,col)*exp( -wavenumber*(beta+im*delta)*stepZ )/normalization;
+  #pragma omp parallel for
+  for ( unsigned int i=0;i<field.n_elem; i++ )
+  {
+    // NOTE: The FFTW normalization is included in the kernel table
+    cdouble exponent = refractionExponent( i, z0, z1 );
+    if ( absorberIsActive ) exponent += absorberExponent(i);
+    field[i] *= static_cast< complex<T> >( exp( exponent ) );
   }
+}
 
+void FFTSolver3D::updateVisualization( const arma::cx_mat &field, double z )
+{
+  assert( plots != NULL ); // Just in case, should never happen at this stage
+  arma::mat values = arma::flipud( arma::abs( field ) );
+  plots->get("Intensity").setCmap( cmap_t::NIPY_SPECTRAL );
+  plots->get("Intensity").setOpacity(1.0);
+  plots->get("Intensity").setColorLim( intensityMin, intensityMax );
+  plots->get("Intensity").setImg( values );
+  plots->draw();
 
-  if ( visRealSpace )
+  if ( overlayRefractiveIndex )
   {
-    assert( plots != NULL ); // Just in case, should never happen at this stage
-    arma::mat values = arma::flipud( arma::abs( *currentSolution ) );
-    plots->get("Intensity").setCmap( cmap_t::NIPY_SPECTRAL );
-    plots->get("Intensity").setOpacity(1.0);
-    plots->get("Intensity").setColorLim( intensityMin, intensityMax );
-    plots->get("Intensity").setImg( values );
-    plots->draw();
+    plots->get("Intensity").setCmap( cmap_t::GREYSCALE );
+    plots->get("Intensity").setOpacity(0.5);
+    arma::mat refr(values);
+    evaluateRefractiveIndex( refr, z );
 
-    if ( overlayRefractiveIndex )
-    {
-      plots->get("Intensity").setCmap( cmap_t::GREYSCALE );
-      plots->get("Intensity").setOpacity(0.5);
-      arma::mat refr(values);
-      evaluateRefractiveIndex( refr, z1 );
-      double refrMin = refr.min();
-      double refrMax = refr.max();
-
-      //plots->get("Intensity").setColorLim( refrMin, refrMax );
-      plots->get("Intensity").setImg( refr );
-      plots->draw();
-    }
-
-    values = arma::flipud( -arma::arg( *currentSolution ) );
-    plots->get("Phase").setImg( values );
+    plots->get("Intensity").setImg( refr );
     plots->draw();
-    plots->show();
+  }
 
-    if ( createAnimation )
-    {
-      stringstream ss;
-      ss << imageName << imgCounter++ << ".png";
-      plots->saveImg( ss.str().c_str() );
-    }
+  values = arma::flipud( -arma::arg( field ) );
+  plots->get("Phase").setImg( values );
+  plots->draw();
+  plots->show();
+
+  if ( createAnimation )
+  {
+    stringstream ss;
+    ss << imageName << imgCounter++ << ".png";
+    plots->saveImg( ss.str().c_str() );
   }
 }
 
@@ -248,14 +450,31 @@ void FFTSolver3D::setPhaseMinMax( double min, double max )
   }
 }
 
-void FFTSolver3D::refractionIntegral( double x, double y, double z1 , double z2, double &delta, double &beta )
+bool FFTSolver3D::evaluateMaterialSlice( double z, arma::mat &delta, arma::mat &beta ) const
+{
+  delta.set_size( prevSolution->n_rows, prevSolution->n_cols );
+  beta.set_size( prevSolution->n_rows, prevSolution->n_cols );
+  bool isVacuum = true;
+
+  #pragma omp parallel for reduction(&&:isVacuum)
+  for ( unsigned int i=0;i<delta.n_elem;i++ )
+  {
+    unsigned int row = i%delta.n_rows;
+    unsigned int col = i/delta.n_rows;
+    guide->getXrayMatProp( guide->getX(col), guide->getY(row), z, delta[i], beta[i] );
+    isVacuum = isVacuum && ( delta[i] == 0.0 ) && ( beta[i] == 0.0 );
+  }
+  return isVacuum;
+}
+
+void FFTSolver3D::refractionIntegral( double x, double y, double z1 , double z2, double delta1, double beta1, double &delta, double &beta )
 {
   double deltaTemp = 0.0;
   double betaTemp = 0.0;
-  guide->getXrayMatProp( x, y, z1, delta, beta );
-  guide->getXrayMatProp( x, y, z2, deltaTemp, betaTemp );
-  delta += deltaTemp;
-  beta += betaTemp;
+
+  // The end points are already known from the material slices
+  delta += delta1;
+  beta += beta1;
   double z = z1;
   double dz = (z2-z1)/nStepsInRefrIntegral;
   for ( unsigned int i=1;i<nStepsInRefrIntegral-1;i++ )
@@ -273,13 +492,16 @@ void FFTSolver3D::refractionIntegral( double x, double y, double z1 , double z2,
 void FFTSolver3D::reset()
 {
   imgCounter = 0;
+  prevSliceIsValid = false;
+  pendingDistance = 0.0;
+  halfRefractionPending = false;
   Solver3D::reset();
-  if ( planInitialized )
-  {
-    fftw_destroy_plan( ftforw );
-    fftw_destroy_plan( ftback );
-    planInitialized = false;
-  }
+}
+
+void FFTSolver3D::setNumberOfThreads( unsigned int nThreads )
+{
+  Solver::setNumberOfThreads( nThreads );
+  plans.setNumberOfThreads( nThreads );
 }
 
 void FFTSolver3D::evaluateRefractiveIndex( arma::mat &refr, double z ) const
@@ -344,29 +566,25 @@ void FFTSolver3D::absorbingBC( double width, double dampingLength )
   absorbY.setThickness( nPixY );
   absorbX.setInverseDampingLength( invDampingX );
   absorbY.setInverseDampingLength( invDampingY );
+
+  // Force the profiles to be tabulated in the next step
+  absorberExponentX.reset();
+  absorberExponentY.reset();
 }
 
-void FFTSolver3D::applyAbsorbingBC()
+void FFTSolver3D::updateAbsorberProfiles()
 {
-  #pragma omp parallel
-  {
-    DimGetter<ApplyDim_t::COL> getter;
-    #pragma omp for
-    for ( unsigned int i=0;i<currentSolution->n_cols;i++ )
-    {
-      getter.fixed = i;
-      absorbY.apply( *currentSolution, getter );
-    }
-  }
+  absorberIsActive = absorbX.isActive() || absorbY.isActive();
+  if ( !absorberIsActive ) return;
 
-  #pragma omp parallel
+  if (( absorberExponentX.n_elem != prevSolution->n_cols ) || ( absorberExponentY.n_elem != prevSolution->n_rows ))
   {
-    DimGetter<ApplyDim_t::ROW> getter;
-    #pragma omp for
-    for ( unsigned int i=0;i<currentSolution->n_rows;i++ )
-    {
-      getter.fixed = i;
-      absorbX.apply( *currentSolution, getter );
-    }
+    absorbX.exponentProfile( prevSolution->n_cols, absorberExponentX );
+    absorbY.exponentProfile( prevSolution->n_rows, absorberExponentY );
   }
 }
+
+double FFTSolver3D::absorberExponent( unsigned int i ) const
+{
+  return absorberExponentX[i/absorberExponentY.n_elem] + absorberExponentY[i%absorberExponentY.n_elem];
+}
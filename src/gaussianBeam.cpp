@@ -57,9 +57,11 @@ cdouble GaussianBeam::angle_factorY(double y) const
 cdouble GaussianBeam::get( double x, double y, double z ) const
 {
   y -= centerY;
+  cdouble im(0.0,1.0);
   double gaussY = exp( -pow(y/spotSize(z-z0),2) );
+  cdouble phaseY = exp( 0.5*im*wavenumber*y*y*inverseRadiusOfCurvature(z-z0) );
   cdouble angY = angle_factorY(y);
-  return get(x,z)*gaussY*angY;
+  return get(x,z)*gaussY*phaseY*angY;
 }
 
 void GaussianBeam::setCenter( double xc, double yc )
@@ -21,7 +21,6 @@ void GenericScattering::setMaxScatteringAngle( double anglemax )
 void GenericScattering::init()
 {
   reset();
-  isReferenceRun = true;
   #ifdef PRINT_DEBUG
     clog << "Initialization started...\n";
     clog << "Set export dimensions and padlength...\n";
@@ -32,6 +31,13 @@ void GenericScattering::init()
   ep.setExportDimensions( exportNx, exportNy );
   ff.setPadLength( FFTPadLength );
   ff.setExportDimensions( exportNx, exportNy );
+  ff.setPlanRigor( fftPlanRigor );
+  fft3Dsolver.setPlanRigor( fftPlanRigor );
+  fft3Dsolver.setSplitting( fftSplitting );
+  fft3Dsolver.setVacuumSkipping( fftVacuumSkipping );
+  fft3Dsolver.setPrecision( fftPrecision );
+  projSolver.setPrecision( fftPrecision );
+  projSolver.setAnalyticProjection( analyticProjection );
 
   #ifdef PRINT_DEBUG
     clog << "Set reference solution array...\n";
@@ -43,7 +49,14 @@ void GenericScattering::init()
 
   setTransverseDiscretization( xmin, xmax, dx, downSampleX );
   setVerticalDiscretization( ymin, ymax, dy );
-  setLongitudinalDiscretization( zmin, zmax, (zmax-zmin)/3.0, 1 ); // Settings for reference run
+  if ( isReferenceRun )
+  {
+    setLongitudinalDiscretization( zmin, zmax, (zmax-zmin)/3.0, 1 ); // Settings for reference run
+  }
+  else
+  {
+    setLongitudinalDiscretization( zmin, zmax, dz, downSampleZ );
+  }
 
   #ifdef PRINT_DEBUG
     clog << "Set wavelength...\n";
@@ -93,6 +106,12 @@ void GenericScattering::init()
     clog << "Set solver and post processing modules...\n";
   #endif
 
+  // The reference run only needs the last plane
+  adisolver.setStoreSolution( !isReferenceRun );
+  fft3Dsolver.setStoreSolution( !isReferenceRun );
+  projSolver.setStoreSolution( !isReferenceRun );
+  hankelSolver.setStoreSolution( !isReferenceRun );
+
   switch ( propagator )
   {
     case SolverType_t::ADI:
@@ -104,6 +123,9 @@ void GenericScattering::init()
     case SolverType_t::PROJ:
       setSolver( projSolver );
       break;
+    case SolverType_t::HANKEL:
+      setSolver( hankelSolver );
+      break;
   }
   /*
   if ( useFFTSolver ) setSolver( fft3Dsolver );
@@ -144,15 +166,121 @@ void GenericScattering::getXrayMatProp( double x, double y, double z, double &de
   material->getXrayMatProp( x, y, z, delta, beta );
 }
 
+bool GenericScattering::hasAnalyticProjection() const
+{
+  return isReferenceRun || (( material != NULL ) && material->hasAnalyticProjection() );
+}
+
+void GenericScattering::getProjectedXrayMatProp( double x, double y, double zmin, double zmax, double &deltaInt, double &betaInt ) const
+{
+  if ( isReferenceRun )
+  {
+    deltaInt = 0.0;
+    betaInt = 0.0;
+    return;
+  }
+  material->getProjectedXrayMatProp( x, y, zmin, zmax, deltaInt, betaInt );
+}
+
 void GenericScattering::solve()
 {
   if ( material == NULL )
   {
     throw( runtime_error("No material set!") );
   }
+  if ( fftwWisdomFile != "" )
+  {
+    FFTPlanManager::loadWisdom( fftwWisdomFile );
+  }
+
+  isReferenceRun = referenceRunIsNeeded();
   init();
   printInfo();
 
+  if ( subtract_reference )
+  {
+    computeReference();
+    ff.setReference( *reference );
+  }
+
+  if ( isReferenceRun )
+  {
+    reset();
+    isReferenceRun = false;
+    if ( realTimeVisualization )
+    {
+      switch( propagator )
+      {
+        case SolverType_t::ADI:
+          adisolver.realTimeVisualization();
+          break;
+        case SolverType_t::FFT:
+          fft3Dsolver.visualizeRealSpace();
+          break;
+      }
+    }
+    // Set resolution for higher
+    setLongitudinalDiscretization( zmin, zmax, dz, downSampleZ );
+    adisolver.setStoreSolution( true );
+    fft3Dsolver.setStoreSolution( true );
+    projSolver.setStoreSolution( true );
+    hankelSolver.setStoreSolution( true );
+    switch( propagator )
+    {
+      case SolverType_t::ADI:
+        adisolver.updateDimensionsOfArrays();
+        break;
+      case SolverType_t::FFT:
+        fft3Dsolver.updateDimensionsOfArrays();
+        break;
+      case SolverType_t::PROJ:
+        projSolver.updateDimensionsOfArrays();
+        break;
+      case SolverType_t::HANKEL:
+        hankelSolver.updateDimensionsOfArrays();
+        break;
+    }
+    setBoundaryConditions( gbeam );
+  }
+  ParaxialSimulation::solve();
+
+  if ( fftwWisdomFile != "" )
+  {
+    FFTPlanManager::saveWisdom( fftwWisdomFile );
+  }
+}
+
+bool GenericScattering::referenceRunIsNeeded() const
+{
+  if ( !subtract_reference ) return false;
+  switch ( referenceMode )
+  {
+    case Reference_t::PROPAGATE:
+      return true;
+    case Reference_t::ANALYTIC:
+      return false;
+    case Reference_t::CACHED:
+      return ( reference == NULL ) || !( cachedReferenceKey == referenceKey() );
+  }
+  return true;
+}
+
+void GenericScattering::computeReference()
+{
+  if ( !isReferenceRun )
+  {
+    if ( referenceMode == Reference_t::ANALYTIC )
+    {
+      analyticReference();
+      clog << "Analytic reference solution computed\n";
+    }
+    else
+    {
+      clog << "Using cached reference solution\n";
+    }
+    return;
+  }
+
   // Reference run
   ParaxialSimulation::solve();
 
@@ -170,45 +298,178 @@ void GenericScattering::solve()
     case SolverType_t::PROJ:
       *reference = projSolver.getLastSolution3D();
       break;
+    case SolverType_t::HANKEL:
+      *reference = hankelSolver.getLastSolution3D();
+      break;
   }
-  //if ( useFFTSolver ) *reference = fft3Dsolver.getLastSolution3D();
-  //else *reference = adisolver.getLastSolution3D();
-
-  if (subtract_reference) ff.setReference( *reference );
+  cachedReferenceKey = referenceKey();
   clog << "Reference solution computed\n";
+}
 
+void GenericScattering::analyticReference()
+{
+  // The source is evaluated at z = 0 at the entrance, so the exit plane is at the length of the domain.
+  // The projection solver does not diffract, hence its reference is the beam at the entrance
+  unsigned int Nx = nodeNumberTransverse();
+  unsigned int Ny = nodeNumberVertical();
+  double length = 0.0;
+  switch ( propagator )
+  {
+    case SolverType_t::PROJ:
+      length = 0.0;
+      break;
+    case SolverType_t::ADI:
+    case SolverType_t::FFT:
+    case SolverType_t::HANKEL:
+      length = zmax-zmin;
+      break;
+  }
+  delete reference;
+  reference = new arma::cx_mat( Ny, Nx );
+  #pragma omp parallel for
+  for ( unsigned int indx=0;indx<Nx*Ny;indx++ )
+  {
+    unsigned int i = indx/Ny;
+    unsigned int j = indx%Ny;
+    (*reference)(j,i) = gbeam.get( getX(i), getY(j), length );
+  }
+}
+
+GenericScattering::ReferenceKey GenericScattering::referenceKey() const
+{
+  ReferenceKey key;
+  key.xmin = xmin;
+  key.xmax = xmax;
+  key.ymin = ymin;
+  key.ymax = ymax;
+  key.zmin = zmin;
+  key.zmax = zmax;
+  key.dx = dx;
+  key.dy = dy;
+  key.downSampleX = downSampleX;
+  key.wavelength = wavelength;
+  key.waist = gbeam.getWaist();
+  key.propagator = propagator;
+  key.splitting = fftSplitting;
+  key.precision = fftPrecision;
+  return key;
+}
+
+bool GenericScattering::ReferenceKey::operator ==( const ReferenceKey &other ) const
+{
+  return ( xmin == other.xmin ) && ( xmax == other.xmax ) && ( ymin == other.ymin ) && ( ymax == other.ymax ) &&
+         ( zmin == other.zmin ) && ( zmax == other.zmax ) && ( dx == other.dx ) && ( dy == other.dy ) &&
+         ( downSampleX == other.downSampleX ) && ( wavelength == other.wavelength ) && ( waist == other.waist ) &&
+         ( propagator == other.propagator ) && ( splitting == other.splitting ) && ( precision == other.precision );
+}
+
+void GenericScattering::solveAgain()
+{
   reset();
   isReferenceRun = false;
-  if ( realTimeVisualization )
+  setBoundaryConditions( gbeam );
+  ParaxialSimulation::solve();
+}
+
+void GenericScattering::scan( geom::Module &sample, const vector<ScanPoint> &points, const char* fname )
+{
+  if ( points.size() == 0 )
   {
-    switch( propagator )
+    throw( runtime_error("The scan has no points!") );
+  }
+
+  vector<arma::mat> initialPose;
+  sample.getTransformations( initialPose );
+
+  vector<H5::DataSet> datasets;
+  hsize_t nPoints = points.size();
+  for ( unsigned int k=0;k<points.size();k++ )
+  {
+    const ScanPoint &point = points[k];
+    sample.setTransformations( initialPose );
+    sample.rotate( point.angleDeg, point.axis );
+    sample.translate( point.x, point.y, point.z );
+
+    // Only the sample changes between the points, so the discretization, the plans and the reference are kept
+    bool samePose = ( k > 0 ) && ( point.angleDeg == points[k-1].angleDeg ) && ( point.axis == points[k-1].axis ) &&
+                    ( point.x == points[k-1].x ) && ( point.y == points[k-1].y ) && ( point.z == points[k-1].z );
+    if ( k == 0 )
     {
-      case SolverType_t::ADI:
-        adisolver.realTimeVisualization();
-        break;
-      case SolverType_t::FFT:
-        fft3Dsolver.visualizeRealSpace();
-        break;
+      solve();
+    }
+    else if ( !samePose )
+    {
+      solveAgain();
+    }
+    clog << "Scan point " << k+1 << " of " << points.size() << " solved\n";
+
+    if ( k == 0 )
+    {
+      // The datasets are created when the size of the results are known
+      if ( file != NULL ) delete file;
+      file = new H5::H5File( fname, H5F_ACC_TRUNC );
+      delete maingroup;
+      maingroup = new H5::Group( file->createGroup(groupname) );
+      setGroupAttributes();
+    }
+
+    unsigned int dsetIndx = 0;
+    for ( unsigned int i=0;i<postProcess.size();i++ )
+    {
+      if ( postProcess[i]->getReturnType( *solver ) != post::PostProcessingModule::ReturnType_t::matrix2D ) continue;
+
+      arma::mat res;
+      postProcess[i]->result( *solver, res );
+      hsize_t count[3] = {1, res.n_cols, res.n_rows};
+      if ( k == 0 )
+      {
+        hsize_t dims[3] = {nPoints, res.n_cols, res.n_rows};
+        H5::DataSpace space( 3, dims );
+        string name( groupname );
+        name += postProcess[i]->getName();
+        datasets.push_back( file->createDataSet( name, H5::PredType::NATIVE_DOUBLE, space ) );
+
+        vector<H5Attr> attrib;
+        postProcess[i]->addAttrib( attrib );
+        for ( unsigned int j=0;j<attrib.size();j++ )
+        {
+          if ( attrib[j].dtype == H5::PredType::NATIVE_INT )
+          {
+            addAttribute( datasets.back(), attrib[j].name.c_str(), static_cast<int>( attrib[j].value ) );
+          }
+          else
+          {
+            addAttribute( datasets.back(), attrib[j].name.c_str(), attrib[j].value );
+          }
+        }
+      }
+
+      hsize_t offset[3] = {k, 0, 0};
+      H5::DataSpace fileSpace = datasets[dsetIndx].getSpace();
+      fileSpace.selectHyperslab( H5S_SELECT_SET, count, offset );
+      H5::DataSpace memSpace( 3, count );
+      datasets[dsetIndx].write( res.memptr(), H5::PredType::NATIVE_DOUBLE, memSpace, fileSpace );
+      dsetIndx++;
     }
-    //if ( useFFTSolver ) fft3Dsolver.visualizeRealSpace();
-    //else adisolver.realTimeVisualization();
   }
-  // Set resolution for higher
-  setLongitudinalDiscretization( zmin, zmax, dz, downSampleZ );
-  switch( propagator )
+  sample.setTransformations( initialPose );
+
+  // Store the poses
+  arma::vec angles( nPoints );
+  arma::vec axes( nPoints );
+  arma::mat translations( 3, nPoints );
+  for ( unsigned int k=0;k<nPoints;k++ )
   {
-    case SolverType_t::ADI:
-      adisolver.updateDimensionsOfArrays();
-      break;
-    case SolverType_t::FFT:
-      fft3Dsolver.updateDimensionsOfArrays();
-      break;
-    case SolverType_t::PROJ:
-      projSolver.updateDimensionsOfArrays();
-      break;
+    angles[k] = points[k].angleDeg;
+    axes[k] = static_cast<int>( points[k].axis );
+    translations(0,k) = points[k].x;
+    translations(1,k) = points[k].y;
+    translations(2,k) = points[k].z;
   }
-  setBoundaryConditions( gbeam );
-  ParaxialSimulation::solve();
+  saveArray( angles, "scanAngle" );
+  saveArray( axes, "scanAxis" );
+  saveArray( translations, "scanTranslation" );
+  clog << "Scan with " << nPoints << " points written to " << fname << endl;
 }
 
 void GenericScattering::printInfo() const
@@ -2,6 +2,7 @@
 #include <stdexcept>
 #include <fstream>
 #include <cassert>
+#include <algorithm>
 
 using namespace std;
 
@@ -107,6 +108,73 @@ bool geom::Part::isInside( double x, double y, double z ) const
   return false;
 }
 
+void geom::Part::zSegments( double x, double y, vector<ZSegment> &segments ) const
+{
+  vector<double> zEnter( shapes.size() );
+  vector<double> zExit( shapes.size() );
+  vector<bool> hit( shapes.size() );
+  vector<double> breakpoints;
+  for ( unsigned int i=0;i<shapes.size();i++ )
+  {
+    hit[i] = shapes[i]->zInterval( x, y, zEnter[i], zExit[i] );
+    if ( !hit[i] ) continue;
+    breakpoints.push_back( zEnter[i] );
+    breakpoints.push_back( zExit[i] );
+  }
+  sort( breakpoints.begin(), breakpoints.end() );
+
+  // The material is constant between two breakpoints, so the same rule as isInside is applied at the midpoint
+  for ( unsigned int k=1;k<breakpoints.size();k++ )
+  {
+    if ( breakpoints[k] <= breakpoints[k-1] ) continue;
+    double z = 0.5*( breakpoints[k-1]+breakpoints[k] );
+    bool inside = false;
+    for ( int i=shapes.size()-1;i>=0;i-- )
+    {
+      if ( hit[i] && ( z > zEnter[i] ) && ( z < zExit[i] ) )
+      {
+        inside = ( operations[i] == Operation_t::UNION );
+        break;
+      }
+    }
+    if ( !inside ) continue;
+
+    if (( segments.size() > 0 ) && ( segments.back().zExit == breakpoints[k-1] ) &&
+        ( segments.back().delta == delta ) && ( segments.back().beta == beta ))
+    {
+      segments.back().zExit = breakpoints[k];
+      continue;
+    }
+    ZSegment segment;
+    segment.zEnter = breakpoints[k-1];
+    segment.zExit = breakpoints[k];
+    segment.delta = delta;
+    segment.beta = beta;
+    segments.push_back( segment );
+  }
+}
+
+void geom::Part::getTransformations( vector<arma::mat> &transformations ) const
+{
+  for ( unsigned int i=0;i<shapes.size();i++ )
+  {
+    transformations.push_back( shapes[i]->getTransformation() );
+  }
+}
+
+unsigned int geom::Part::setTransformations( const vector<arma::mat> &transformations, unsigned int start )
+{
+  if ( start+shapes.size() > transformations.size() )
+  {
+    throw( runtime_error("The number of transformations does not match the number of shapes!") );
+  }
+  for ( unsigned int i=0;i<shapes.size();i++ )
+  {
+    shapes[i]->setTransformation( transformations[start+i] );
+  }
+  return start+shapes.size();
+}
+
 void geom::Part::save( const char* fname ) const
 {
   if ( shapes.size() <= 1 )
@@ -233,6 +301,46 @@ bool geom::Module::getXrayMatProp( double x, double y, double z, double &delta,
   return false;
 }
 
+void geom::Module::zSegments( double x, double y, vector<ZSegment> &segments ) const
+{
+  vector< vector<ZSegment> > partSegments( parts.size() );
+  vector<double> breakpoints;
+  for ( unsigned int i=0;i<parts.size();i++ )
+  {
+    parts[i]->zSegments( x, y, partSegments[i] );
+    for ( unsigned int j=0;j<partSegments[i].size();j++ )
+    {
+      breakpoints.push_back( partSegments[i][j].zEnter );
+      breakpoints.push_back( partSegments[i][j].zExit );
+    }
+  }
+  sort( breakpoints.begin(), breakpoints.end() );
+
+  // The last part containing the midpoint decides, as in getXrayMatProp
+  for ( unsigned int k=1;k<breakpoints.size();k++ )
+  {
+    if ( breakpoints[k] <= breakpoints[k-1] ) continue;
+    double z = 0.5*( breakpoints[k-1]+breakpoints[k] );
+    for ( int i=parts.size()-1;i>=0;i-- )
+    {
+      bool inside = false;
+      for ( unsigned int j=0;j<partSegments[i].size();j++ )
+      {
+        inside = inside || (( z > partSegments[i][j].zEnter ) && ( z < partSegments[i][j].zExit ));
+      }
+      if ( !inside ) continue;
+
+      ZSegment segment;
+      segment.zEnter = breakpoints[k-1];
+      segment.zExit = breakpoints[k];
+      segment.delta = ( operations[i] == Operation_t::UNION ) ? parts[i]->delta:0.0;
+      segment.beta = ( operations[i] == Operation_t::UNION ) ? parts[i]->beta:0.0;
+      segments.push_back( segment );
+      break;
+    }
+  }
+}
+
 void geom::Module::translate( double x, double y, double z )
 {
   for ( unsigned int i=0;i<parts.size();i++ )
@@ -257,6 +365,24 @@ void geom::Module::scale( double factor, geom::Axis_t axis )
   }
 }
 
+void geom::Module::getTransformations( vector<arma::mat> &transformations ) const
+{
+  transformations.clear();
+  for ( unsigned int i=0;i<parts.size();i++ )
+  {
+    parts[i]->getTransformations( transformations );
+  }
+}
+
+void geom::Module::setTransformations( const vector<arma::mat> &transformations )
+{
+  unsigned int next = 0;
+  for ( unsigned int i=0;i<parts.size();i++ )
+  {
+    next = parts[i]->setTransformations( transformations, next );
+  }
+}
+
 void geom::Module::saveIndividualParts( const char* prefix )
 {
   for ( unsigned int i=0;i<parts.size();i++ )
@@ -0,0 +1,306 @@
+#include "hankelSolver3D.hpp"
+#include "paraxialSimulation.hpp"
+#include <gsl/gsl_sf_bessel.h>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <sstream>
+
+using namespace std;
+
+void HankelSolver3D::setSimulator( ParaxialSimulation &sim )
+{
+  Solver::setSimulator( sim );
+  Nx = guide->nodeNumberTransverse();
+  Nz = guide->nodeNumberLongitudinal();
+  Ny = guide->nodeNumberVertical();
+
+  unsigned int downSampledX = Nx/guide->transverseDiscretization().downsamplingRatio;
+  unsigned int downSampledY = Ny/guide->verticalDiscretization().downsamplingRatio;
+  unsigned int downSampledZ = Nz/guide->longitudinalDiscretization().downsamplingRatio;
+
+  // Only the stored planes are kept on the Cartesian grid
+  delete solution; solution=NULL;
+  delete prevSolution; prevSolution=NULL;
+  delete currentSolution; currentSolution=NULL;
+  unsigned int nSlices = storeSolution ? downSampledZ+1:0;
+  solution = new arma::cx_cube( downSampledY, downSampledX, nSlices );
+
+  computeGrid();
+  prevSliceIsValid = false;
+  cartesianIsOutdated = true;
+}
+
+void HankelSolver3D::computeGrid()
+{
+  unsigned int N = nRadialNodes > 0 ? nRadialNodes : Nx/2;
+  radius = max( abs(guide->transverseDiscretization().min), abs(guide->transverseDiscretization().max) );
+  radius = max( radius, abs(guide->verticalDiscretization().min) );
+  radius = max( radius, abs(guide->verticalDiscretization().max) );
+
+  besselZeros.set_size( N+1 );
+  besselJ1.set_size( N+1 );
+  for ( unsigned int n=0;n<N+1;n++ )
+  {
+    besselZeros[n] = gsl_sf_bessel_zero_J0( n+1 );
+    besselJ1[n] = abs( gsl_sf_bessel_J1( besselZeros[n] ) );
+  }
+
+  double S = besselZeros[N];
+  rNodes.set_size( N );
+  for ( unsigned int n=0;n<N;n++ )
+  {
+    rNodes[n] = besselZeros[n]*radius/S;
+  }
+
+  radialField.set_size( N );
+  radialField.fill( 0.0 );
+  radialWork.set_size( N );
+
+  // Force the propagator to be recomputed
+  transform.set_size( 0, 0 );
+  diffraction.set_size( 0 );
+}
+
+bool HankelSolver3D::propagatorIsOutdated() const
+{
+  if (( transform.n_rows != rNodes.n_elem ) || ( diffraction.n_elem != rNodes.n_elem ))
+  {
+    return true;
+  }
+  return ( propStepZ != guide->longitudinalDiscretization().step ) ||
+         ( propWavenumber != guide->getWavenumber() );
+}
+
+void HankelSolver3D::computePropagator()
+{
+  propStepZ = guide->longitudinalDiscretization().step;
+  propWavenumber = guide->getWavenumber();
+  unsigned int N = rNodes.n_elem;
+  double S = besselZeros[N];
+
+  // The transformation matrix only depends on the grid
+  if ( transform.n_rows != N )
+  {
+    transform.set_size( N, N );
+    #pragma omp parallel for
+    for ( unsigned int i=0;i<N*N;i++ )
+    {
+      unsigned int m = i%N;
+      unsigned int n = i/N;
+      transform(m,n) = 2.0*gsl_sf_bessel_J0( besselZeros[m]*besselZeros[n]/S )/( besselJ1[m]*besselJ1[n]*S );
+    }
+  }
+
+  // The transverse wave vector corresponding to node m is besselZeros[m]/radius
+  cdouble A( 0.0, 0.5*propStepZ/propWavenumber );
+  diffraction.set_size( N );
+  for ( unsigned int m=0;m<N;m++ )
+  {
+    double kr = besselZeros[m]/radius;
+    diffraction[m] = exp( -A*kr*kr );
+  }
+}
+
+void HankelSolver3D::applyTransform( const arma::cx_vec &in, arma::cx_vec &out ) const
+{
+  arma::vec realPart = transform*arma::real( in );
+  arma::vec imagPart = transform*arma::imag( in );
+  out.set_size( in.n_elem );
+  for ( unsigned int n=0;n<in.n_elem;n++ )
+  {
+    out[n] = cdouble( realPart[n], imagPart[n] );
+  }
+}
+
+void HankelSolver3D::setInitialConditions( const arma::cx_mat &values )
+{
+  if (( solution == NULL ) || ( rNodes.n_elem == 0 ))
+  {
+    throw ( runtime_error("The function setSimulator needs to be called before setInitialConditions!") );
+  }
+
+  if (( values.n_rows != Ny ) || ( values.n_cols != Nx ))
+  {
+    stringstream ss;
+    ss << "Dimension of matrices does not match!\n";
+    ss << "Given: Nrows: " << values.n_rows << " Ncols: " << values.n_cols;
+    ss << "\nRequired: Nrows: " << Ny << " Ncols: " << Nx;
+    throw( runtime_error( ss.str() ) );
+  }
+
+  // Sample along the row closest to y = 0
+  double ymin = guide->verticalDiscretization().min;
+  double dy = guide->verticalDiscretization().step;
+  int row = static_cast<int>( -ymin/dy + 0.5 );
+  row = max( 0, min( row, static_cast<int>(Ny)-1 ) );
+
+  double xmin = guide->transverseDiscretization().min;
+  double dx = guide->transverseDiscretization().step;
+  for ( unsigned int n=0;n<rNodes.n_elem;n++ )
+  {
+    double pos = ( rNodes[n]-xmin )/dx;
+    int col = static_cast<int>( pos );
+    if ( col >= static_cast<int>(Nx)-1 )
+    {
+      radialField[n] = values( row, Nx-1 );
+      continue;
+    }
+    double weight = pos-col;
+    radialField[n] = (1.0-weight)*values( row, col ) + weight*values( row, col+1 );
+  }
+
+  cartesianIsOutdated = true;
+  if ( solution->n_slices > 0 )
+  {
+    render( solution->slice(0), Ny*dy/solution->n_rows, Nx*dx/solution->n_cols );
+  }
+}
+
+void HankelSolver3D::step()
+{
+  solveStep( currentStep );
+  cartesianIsOutdated = true;
+
+  if ( currentStep%guide->longitudinalDiscretization().downsamplingRatio == 0 )
+  {
+    unsigned int currZ = currentStep/guide->longitudinalDiscretization().downsamplingRatio;
+    if ( currZ < solution->n_slices )
+    {
+      double rowStep = Ny*guide->verticalDiscretization().step/solution->n_rows;
+      double colStep = Nx*guide->transverseDiscretization().step/solution->n_cols;
+      render( solution->slice(currZ), rowStep, colStep );
+    }
+  }
+  currentStep++;
+}
+
+void HankelSolver3D::solveStep( unsigned int step )
+{
+  if ( propagatorIsOutdated() )
+  {
+    computePropagator();
+  }
+
+  // Diffraction: O(N^2) matrix-vector products. The field is scaled by 1/|J1| before the transform and back afterwards
+  unsigned int N = rNodes.n_elem;
+  for ( unsigned int n=0;n<N;n++ )
+  {
+    radialWork[n] = radialField[n]/besselJ1[n];
+  }
+  applyTransform( radialWork, radialField );
+  for ( unsigned int m=0;m<N;m++ )
+  {
+    radialField[m] *= diffraction[m];
+  }
+  applyTransform( radialField, radialWork );
+  for ( unsigned int n=0;n<N;n++ )
+  {
+    radialWork[n] *= besselJ1[n];
+  }
+
+  double stepZ = guide->longitudinalDiscretization().step;
+  double wavenumber = guide->getWavenumber();
+  double z1 = guide->getZ( step );
+  double z0 = guide->getZ( step-1 );
+  cdouble im(0.0,1.0);
+  const double ZERO = 1E-10;
+
+  if ( !prevSliceIsValid || ( deltaPrev.n_elem != rNodes.n_elem ) )
+  {
+    evaluateMaterial( z0, deltaPrev, betaPrev );
+  }
+  evaluateMaterial( z1, delta, beta );
+
+  #pragma omp parallel for
+  for ( unsigned int n=0;n<rNodes.n_elem;n++ )
+  {
+    double deltaAvg = delta[n];
+    double betaAvg = beta[n];
+    if (( abs(delta[n]-deltaPrev[n]) > ZERO ) || ( abs(beta[n]-betaPrev[n]) > ZERO ))
+    {
+      // Wave has crossed a border
+      refractionIntegral( n, z0, z1, deltaAvg, betaAvg );
+    }
+    radialField[n] = radialWork[n]*exp( -wavenumber*(betaAvg+im*deltaAvg)*stepZ );
+  }
+
+  deltaPrev.swap( delta );
+  betaPrev.swap( beta );
+  prevSliceIsValid = true;
+}
+
+void HankelSolver3D::evaluateMaterial( double z, arma::vec &deltaRad, arma::vec &betaRad ) const
+{
+  deltaRad.set_size( rNodes.n_elem );
+  betaRad.set_size( rNodes.n_elem );
+
+  #pragma omp parallel for
+  for ( unsigned int n=0;n<rNodes.n_elem;n++ )
+  {
+    guide->getXrayMatProp( rNodes[n], 0.0, z, deltaRad[n], betaRad[n] );
+  }
+}
+
+void HankelSolver3D::refractionIntegral( unsigned int n, double z1, double z2, double &deltaAvg, double &betaAvg ) const
+{
+  double deltaTemp = 0.0;
+  double betaTemp = 0.0;
+  deltaAvg = deltaPrev[n] + delta[n];
+  betaAvg = betaPrev[n] + beta[n];
+  double dz = (z2-z1)/nStepsInRefrIntegral;
+  for ( unsigned int i=1;i<nStepsInRefrIntegral;i++ )
+  {
+    guide->getXrayMatProp( rNodes[n], 0.0, z1+i*dz, deltaTemp, betaTemp );
+    deltaAvg += 2.0*deltaTemp;
+    betaAvg += 2.0*betaTemp;
+  }
+  deltaAvg /= (2.0*nStepsInRefrIntegral);
+  betaAvg /= (2.0*nStepsInRefrIntegral);
+}
+
+cdouble HankelSolver3D::interpolate( double r ) const
+{
+  unsigned int N = rNodes.n_elem;
+  if ( r <= rNodes[0] ) return radialField[0];
+  if ( r >= rNodes[N-1] ) return 0.0;
+
+  const double *begin = rNodes.memptr();
+  unsigned int upper = upper_bound( begin, begin+N, r ) - begin;
+  double weight = ( r-rNodes[upper-1] )/( rNodes[upper]-rNodes[upper-1] );
+  return (1.0-weight)*radialField[upper-1] + weight*radialField[upper];
+}
+
+void HankelSolver3D::render( arma::cx_mat &mat, double rowStep, double colStep ) const
+{
+  double xmin = guide->transverseDiscretization().min;
+  double ymin = guide->verticalDiscretization().min;
+
+  #pragma omp parallel for
+  for ( unsigned int i=0;i<mat.n_elem;i++ )
+  {
+    unsigned int row = i%mat.n_rows;
+    unsigned int col = i/mat.n_rows;
+    double x = xmin + col*colStep;
+    double y = ymin + row*rowStep;
+    mat[i] = interpolate( sqrt( x*x + y*y ) );
+  }
+}
+
+const arma::cx_mat& HankelSolver3D::getLastSolution3D() const
+{
+  if ( cartesianIsOutdated )
+  {
+    cartesian.set_size( Ny, Nx );
+    render( cartesian, guide->verticalDiscretization().step, guide->transverseDiscretization().step );
+    cartesianIsOutdated = false;
+  }
+  return cartesian;
+}
+
+void HankelSolver3D::reset()
+{
+  prevSliceIsValid = false;
+  cartesianIsOutdated = true;
+  Solver3D::reset();
+}
@@ -1,4 +1,13 @@
 #include "materialFunction.hpp"
+#include <stdexcept>
+#include <algorithm>
+
+using namespace std;
+
+void MaterialFunction::getProjectedXrayMatProp( double x, double y, double zmin, double zmax, double &deltaInt, double &betaInt ) const
+{
+  throw( runtime_error("The material does not support analytic projections!") );
+}
 
 void CSGMaterial::getXrayMatProp( double x, double y, double z, double &delta, double &beta ) const
 {
@@ -16,3 +25,50 @@ void CSGMaterial::addModule( const geom::Module &newmodule )
 {
   modules.push_back( &newmodule );
 }
+
+void CSGMaterial::getProjectedXrayMatProp( double x, double y, double zmin, double zmax, double &deltaInt, double &betaInt ) const
+{
+  deltaInt = 0.0;
+  betaInt = 0.0;
+  if ( isReferenceRun ) return;
+
+  vector< vector<geom::ZSegment> > moduleSegments( modules.size() );
+  vector<double> breakpoints;
+  breakpoints.push_back( zmin );
+  breakpoints.push_back( zmax );
+  for ( unsigned int i=0;i<modules.size();i++ )
+  {
+    modules[i]->zSegments( x, y, moduleSegments[i] );
+    for ( unsigned int j=0;j<moduleSegments[i].size();j++ )
+    {
+      breakpoints.push_back( moduleSegments[i][j].zEnter );
+      breakpoints.push_back( moduleSegments[i][j].zExit );
+    }
+  }
+  sort( breakpoints.begin(), breakpoints.end() );
+
+  // The first module containing the midpoint decides, as in getXrayMatProp
+  for ( unsigned int k=1;k<breakpoints.size();k++ )
+  {
+    double start = breakpoints[k-1] > zmin ? breakpoints[k-1]:zmin;
+    double end = breakpoints[k] < zmax ? breakpoints[k]:zmax;
+    if ( end <= start ) continue;
+    double z = 0.5*( start+end );
+
+    bool found = false;
+    for ( unsigned int i=0;( i<modules.size() ) && !found;i++ )
+    {
+      for ( unsigned int j=0;j<moduleSegments[i].size();j++ )
+      {
+        const geom::ZSegment &seg = moduleSegments[i][j];
+        if (( z > seg.zEnter ) && ( z < seg.zExit ))
+        {
+          deltaInt += seg.delta*( end-start );
+          betaInt += seg.beta*( end-start );
+          found = true;
+          break;
+        }
+      }
+    }
+  }
+}
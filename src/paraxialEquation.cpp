@@ -1,4 +1,5 @@
 #include "paraxialEquation.hpp"
+#include <typeinfo>
 
 double ParaxialEquation::F( double x, double z ) const
 {
@@ -25,3 +26,9 @@ cdouble ParaxialEquation::phaseFactor( double k, double z ) const
   cdouble im(0.0,1.0);
   return exp(im*k*z);
 }
+
+bool ParaxialEquation::isZIndependent() const
+{
+  // Derived classes may have overridden F, G, H or J
+  return typeid(*this) == typeid(ParaxialEquation);
+}
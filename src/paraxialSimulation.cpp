@@ -128,6 +128,13 @@ void ParaxialSimulation::setSolver( Solver &solv )
 
   solver = &solv;
   solver->setSimulator( *this );
+  solver->setNumberOfThreads( numberOfThreads );
+}
+
+void ParaxialSimulation::setNumberOfThreads( unsigned int nThreads )
+{
+  numberOfThreads = nThreads;
+  if ( solver != NULL ) solver->setNumberOfThreads( nThreads );
 }
 
 void ParaxialSimulation::save( const string &fname )
@@ -381,7 +388,7 @@ void ParaxialSimulation::setBoundaryConditions( const ParaxialSource &source )
     case Dim_t::THREE_D:
     {
       unsigned int Ny = nodeNumberVertical();
-      arma::cx_mat values(Nx, Ny);
+      arma::cx_mat values(Ny, Nx);
       #pragma omp parallel for
       for ( unsigned int indx=0;indx<Nx*Ny;indx++ )
       {
@@ -535,3 +542,21 @@ void ParaxialSimulation::getXrayMatProp( double x, double y, double z, double &d
     beta = 0.0;
   }
 }
+
+bool ParaxialSimulation::hasAnalyticProjection() const
+{
+  return ( material == nullptr ) || material->hasAnalyticProjection();
+}
+
+void ParaxialSimulation::getProjectedXrayMatProp( double x, double y, double zmin, double zmax, double &deltaInt, double &betaInt ) const
+{
+  if ( material != nullptr )
+  {
+    material->getProjectedXrayMatProp( x, y, zmin, zmax, deltaInt, betaInt );
+  }
+  else
+  {
+    deltaInt = 0.0;
+    betaInt = 0.0;
+  }
+}
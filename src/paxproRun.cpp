@@ -0,0 +1,139 @@
+#include "sceneRunner.hpp"
+#include "simulationScheduler.hpp"
+#include <omp.h>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/** Prints the command line options */
+void printUsage()
+{
+  cout << "Usage: paxpro-run [options] scene.json [scene2.json ...]\n";
+  cout << "Solves the scenes and saves the results to the output files given in them\n";
+  cout << "Options:\n";
+  cout << "  --jobs N          Number of scenes solved at the same time (default: derived from the number of cores)\n";
+  cout << "  --threads N       Number of threads for each scene (default: the cores are split evenly)\n";
+  cout << "  --affinity MODE   Thread binding when several scenes are given: none, cores or numa (default: none)\n";
+  cout << "  --help            Prints this message\n";
+}
+
+/** Main function of the stand-alone runner */
+int main( int argc, char **argv )
+{
+  vector<string> sceneFiles;
+  unsigned int nJobs = 0;
+  unsigned int nThreads = 0;
+  Affinity_t affinity = Affinity_t::NONE;
+  for ( int i=1;i<argc;i++ )
+  {
+    string arg( argv[i] );
+    bool hasValue = ( i+1 < argc );
+    if ( arg == "--help" )
+    {
+      printUsage();
+      return 0;
+    }
+    else if (( arg == "--jobs" ) && hasValue )
+    {
+      nJobs = atoi( argv[++i] );
+    }
+    else if (( arg == "--threads" ) && hasValue )
+    {
+      nThreads = atoi( argv[++i] );
+    }
+    else if (( arg == "--affinity" ) && hasValue )
+    {
+      string mode( argv[++i] );
+      if ( mode == "none" ) affinity = Affinity_t::NONE;
+      else if ( mode == "cores" ) affinity = Affinity_t::CORES;
+      else if ( mode == "numa" ) affinity = Affinity_t::NUMA;
+      else
+      {
+        cout << "Unknown affinity " << mode << endl;
+        return 1;
+      }
+    }
+    else if ( arg.compare( 0, 2, "--" ) == 0 )
+    {
+      cout << "Unknown option " << arg << endl;
+      printUsage();
+      return 1;
+    }
+    else
+    {
+      sceneFiles.push_back( arg );
+    }
+  }
+
+  if ( sceneFiles.empty() )
+  {
+    printUsage();
+    return 1;
+  }
+
+  vector<SceneRunner*> runners;
+  int exitCode = 0;
+  try
+  {
+    for ( unsigned int i=0;i<sceneFiles.size();i++ )
+    {
+      runners.push_back( new SceneRunner() );
+      runners.back()->load( sceneFiles[i] );
+    }
+
+    if ( runners.size() == 1 )
+    {
+      if ( nThreads > 0 ) omp_set_num_threads( nThreads );
+      runners[0]->run();
+    }
+    else
+    {
+      // Scans write their own files, so they are run one at a time after the other scenes
+      SimulationScheduler scheduler;
+      scheduler.setConcurrentJobs( nJobs );
+      scheduler.setThreadsPerJob( nThreads );
+      scheduler.setAffinity( affinity );
+      vector<unsigned int> scheduledScenes;
+      for ( unsigned int i=0;i<runners.size();i++ )
+      {
+        if ( runners[i]->hasScan() ) continue;
+        scheduler.add( runners[i]->getSimulation(), runners[i]->getOutputFile() );
+        scheduledScenes.push_back( i );
+      }
+
+      scheduler.run();
+      for ( unsigned int i=0;i<scheduledScenes.size();i++ )
+      {
+        if ( !scheduler.succeeded(i) )
+        {
+          cout << sceneFiles[scheduledScenes[i]] << " failed: " << scheduler.getError(i) << endl;
+          exitCode = 1;
+        }
+      }
+
+      for ( unsigned int i=0;i<runners.size();i++ )
+      {
+        if ( runners[i]->hasScan() ) runners[i]->run();
+      }
+    }
+  }
+  catch ( exception &exc )
+  {
+    cout << exc.what() << endl;
+    exitCode = 1;
+  }
+  catch (...)
+  {
+    cout << "Unrecognized exception!\n";
+    exitCode = 1;
+  }
+
+  for ( unsigned int i=0;i<runners.size();i++ )
+  {
+    delete runners[i];
+  }
+  return exitCode;
+}
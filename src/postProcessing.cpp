@@ -30,20 +30,37 @@ void post::PostProcessingModule::resizeMatrix( const arma::mat &orig, arma::mat
 {
   assert( exportCols != 0 );
   assert( exportRows != 0 );
-  if (( exportRows >= orig.n_rows ) || ( exportCols >= orig.n_cols ))
+
+  // Each direction is only reduced if it is larger than the export size
+  unsigned int nrows = exportRows < orig.n_rows ? exportRows:orig.n_rows;
+  unsigned int ncols = exportCols < orig.n_cols ? exportCols:orig.n_cols;
+  if (( nrows == orig.n_rows ) && ( ncols == orig.n_cols ))
   {
     resized = orig;
     return;
   }
 
-  double deltaX = static_cast<double>(orig.n_cols)/(static_cast<double>(exportCols)+1.0);
-  double deltaY = static_cast<double>(orig.n_rows)/(static_cast<double>(exportRows)+1.0);
-  resized.set_size( exportRows, exportCols );
-  for ( unsigned int i=0;i<exportCols;i++ )
+  double deltaX = 1.0;
+  double deltaY = 1.0;
+  unsigned int spanX = 0;
+  unsigned int spanY = 0;
+  if ( ncols < orig.n_cols )
+  {
+    deltaX = static_cast<double>(orig.n_cols)/(static_cast<double>(ncols)+1.0);
+    spanX = 1;
+  }
+  if ( nrows < orig.n_rows )
+  {
+    deltaY = static_cast<double>(orig.n_rows)/(static_cast<double>(nrows)+1.0);
+    spanY = 1;
+  }
+
+  resized.set_size( nrows, ncols );
+  for ( unsigned int i=0;i<ncols;i++ )
   {
-    for ( unsigned int j=0;j<exportRows;j++ )
+    for ( unsigned int j=0;j<nrows;j++ )
     {
-      resized(j,i) = arma::mean( arma::mean(orig.submat(j*deltaY,i*deltaX, (j+1)*deltaY, (i+1)*deltaX)) );
+      resized(j,i) = arma::mean( arma::mean(orig.submat(j*deltaY,i*deltaX, (j+spanY)*deltaY, (i+spanX)*deltaX)) );
     }
   }
 }
@@ -1,9 +1,11 @@
 #include "projectionSolver.hpp"
 #include "paraxialSimulation.hpp"
 #include <complex>
+#include <iostream>
 
 using namespace std;
 typedef complex<double> cdouble;
+typedef complex<float> cfloat;
 
 void ProjectionSolver::solveStep( unsigned int step )
 {
@@ -12,6 +14,14 @@ void ProjectionSolver::solveStep( unsigned int step )
   double z = guide->getZ( step );
   cdouble im(0.0,1.0);
 
+  if ( precision == Precision_t::SINGLE )
+  {
+    if (( step == 1 ) || ( fieldSingle.n_rows != prevSolution->n_rows ) || ( fieldSingle.n_cols != prevSolution->n_cols ))
+    {
+      fieldSingle = arma::conv_to<arma::cx_fmat>::from( *prevSolution );
+    }
+  }
+
   #pragma omp parallel for
   for ( unsigned int i=0;i<prevSolution->n_cols*prevSolution->n_rows; i++ )
   {
@@ -23,6 +33,77 @@ void ProjectionSolver::solveStep( unsigned int step )
     double delta, beta;
     guide->getXrayMatProp( x, y, z, delta, beta );
 
-    (*currentSolution)(row,col) = (*prevSolution)(row,col)*exp( -wavenumber*(beta+im*delta)*stepZ );
+    if ( precision == Precision_t::SINGLE )
+    {
+      fieldSingle(row,col) *= static_cast<cfloat>( exp( -wavenumber*(beta+im*delta)*stepZ ) );
+    }
+    else
+    {
+      (*currentSolution)(row,col) = (*prevSolution)(row,col)*exp( -wavenumber*(beta+im*delta)*stepZ );
+    }
+  }
+
+  if (( precision == Precision_t::SINGLE ) && isStoredStep( step ))
+  {
+    *currentSolution = arma::conv_to<arma::cx_mat>::from( fieldSingle );
+  }
+}
+
+void ProjectionSolver::analyticStep( unsigned int step )
+{
+  double wavenumber = guide->getWavenumber();
+  double zStart = guide->getZ( lastAnalyticStep );
+  double zEnd = guide->getZ( step );
+  cdouble im(0.0,1.0);
+
+  // Each pixel is independent, so the entire projection is done in one parallel pass
+  #pragma omp parallel for
+  for ( unsigned int i=0;i<prevSolution->n_cols*prevSolution->n_rows; i++ )
+  {
+    unsigned int row = i%prevSolution->n_rows;
+    unsigned int col = i/prevSolution->n_rows;
+
+    double x = guide->getX(col);
+    double y = guide->getY(row);
+    double deltaInt, betaInt;
+    guide->getProjectedXrayMatProp( x, y, zStart, zEnd, deltaInt, betaInt );
+    (*currentSolution)(row,col) = (*prevSolution)(row,col)*exp( -wavenumber*(betaInt+im*deltaInt) );
+  }
+  lastAnalyticStep = step;
+}
+
+void ProjectionSolver::step()
+{
+  bool useAnalytic = analyticProjection && guide->hasAnalyticProjection();
+  if ( analyticProjection && !useAnalytic && printFallbackWarning )
+  {
+    clog << "Warning: The material does not support analytic projections. Integrating slice by slice\n";
+    printFallbackWarning = false;
+  }
+
+  if ( useAnalytic )
+  {
+    // Only the stored planes are needed, the transmission in between is included in the line integrals
+    if ( currentStep == 1 ) lastAnalyticStep = 0;
+    if ( isStoredStep( currentStep ) )
+    {
+      analyticStep( currentStep );
+      copyCurrentSolution( currentStep );
+    }
+    currentStep++;
+    return;
+  }
+
+  if ( precision == Precision_t::DOUBLE )
+  {
+    Solver3D::step();
+    return;
+  }
+
+  solveStep( currentStep );
+  if ( isStoredStep( currentStep ) )
+  {
+    copyCurrentSolution( currentStep );
   }
+  currentStep++;
 }
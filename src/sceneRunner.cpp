@@ -0,0 +1,509 @@
+#include "sceneRunner.hpp"
+#include "postProcessMod.hpp"
+#include <json/reader.h>
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+
+/** Returns a lower case copy of the string */
+static string lowerCase( const string &str )
+{
+  string lower( str );
+  transform( lower.begin(), lower.end(), lower.begin(), ::tolower );
+  return lower;
+}
+
+SceneRunner::~SceneRunner()
+{
+  clear();
+}
+
+void SceneRunner::clear()
+{
+  // The simulation and the material refer to the CSG objects, so they are deleted first
+  delete simulation; simulation = NULL;
+  delete material; material = NULL;
+  for ( unsigned int i=0;i<postProcess.size();i++ ) delete postProcess[i];
+  for ( unsigned int i=0;i<modules.size();i++ ) delete modules[i];
+  for ( unsigned int i=0;i<parts.size();i++ ) delete parts[i];
+  for ( unsigned int i=0;i<shapes.size();i++ ) delete shapes[i];
+  postProcess.clear();
+  modules.clear();
+  parts.clear();
+  shapes.clear();
+  scanPoints.clear();
+  scanModule = 0;
+  outputFile = "";
+}
+
+void SceneRunner::load( const string &fname )
+{
+  ifstream in( fname.c_str() );
+  if ( !in.good() )
+  {
+    throw( runtime_error("Could not open the scene file "+fname+"!") );
+  }
+
+  Json::CharReaderBuilder builder;
+  Json::Value scene;
+  string errors;
+  if ( !Json::parseFromStream( builder, in, &scene, &errors ) )
+  {
+    throw( runtime_error("Could not parse "+fname+":\n"+errors) );
+  }
+  build( scene );
+}
+
+void SceneRunner::build( const Json::Value &scene )
+{
+  clear();
+  if ( !scene.isObject() )
+  {
+    throw( runtime_error("The scene has to be a JSON object!") );
+  }
+  checkKeys( scene, {"name", "description", "output", "wavelength", "beamWaist", "maxScatteringAngle", "FFTPadLength",
+                     "domain", "solver", "material", "postProcessing", "scan"}, "scene" );
+
+  string name = getString( scene, "name", "scene", "scene" );
+  simulation = new GenericScattering( name.c_str() );
+  simulation->description = getString( scene, "description", "", "scene" );
+  outputFile = getString( scene, "output", name+".h5", "scene" );
+  simulation->wavelength = getDouble( scene, "wavelength", simulation->wavelength, "scene" );
+  simulation->setBeamWaist( getDouble( scene, "beamWaist", 1.0, "scene" ) );
+  simulation->setMaxScatteringAngle( getDouble( scene, "maxScatteringAngle", 0.05, "scene" ) );
+  simulation->FFTPadLength = getUint( scene, "FFTPadLength", simulation->FFTPadLength, "scene" );
+
+  readDomain( required( scene, "domain", "scene" ) );
+  if ( scene.isMember("solver") ) readSolver( scene["solver"] );
+  readMaterial( required( scene, "material", "scene" ) );
+  if ( scene.isMember("postProcessing") ) readPostProcessing( scene["postProcessing"] );
+  if ( scene.isMember("scan") ) readScan( scene["scan"] );
+}
+
+void SceneRunner::readDomain( const Json::Value &domain )
+{
+  const string ctx("domain");
+  checkKeys( domain, {"xmin", "xmax", "ymin", "ymax", "zmin", "zmax", "dx", "dy", "dz",
+                      "downSampleX", "downSampleY", "downSampleZ", "exportNx", "exportNy"}, ctx );
+  GenericScattering &sim = *simulation;
+  sim.xmin = getDouble( domain, "xmin", sim.xmin, ctx );
+  sim.xmax = getDouble( domain, "xmax", sim.xmax, ctx );
+  sim.ymin = getDouble( domain, "ymin", sim.ymin, ctx );
+  sim.ymax = getDouble( domain, "ymax", sim.ymax, ctx );
+  sim.zmin = getDouble( domain, "zmin", sim.zmin, ctx );
+  sim.zmax = getDouble( domain, "zmax", sim.zmax, ctx );
+  sim.dx = getDouble( domain, "dx", sim.dx, ctx );
+  sim.dy = getDouble( domain, "dy", sim.dx, ctx );
+  sim.dz = getDouble( domain, "dz", sim.dz, ctx );
+  sim.downSampleX = getUint( domain, "downSampleX", sim.downSampleX, ctx );
+  sim.downSampleY = getUint( domain, "downSampleY", sim.downSampleY, ctx );
+  sim.downSampleZ = getUint( domain, "downSampleZ", sim.downSampleZ, ctx );
+  sim.exportNx = getUint( domain, "exportNx", sim.exportNx, ctx );
+  sim.exportNy = getUint( domain, "exportNy", sim.exportNy, ctx );
+}
+
+void SceneRunner::readSolver( const Json::Value &solver )
+{
+  const string ctx("solver");
+  checkKeys( solver, {"type", "splitting", "precision", "planRigor", "analyticProjection", "reference",
+                      "subtractReference", "threads", "wisdomFile", "supressMessages"}, ctx );
+  GenericScattering &sim = *simulation;
+  if ( solver.isMember("type") ) sim.propagator = solverFromString( getString( solver, "type", "", ctx ) );
+  if ( solver.isMember("splitting") ) sim.fftSplitting = splittingFromString( getString( solver, "splitting", "", ctx ) );
+  if ( solver.isMember("precision") ) sim.fftPrecision = precisionFromString( getString( solver, "precision", "", ctx ) );
+  if ( solver.isMember("planRigor") ) sim.fftPlanRigor = rigorFromString( getString( solver, "planRigor", "", ctx ) );
+  if ( solver.isMember("reference") ) sim.referenceMode = referenceFromString( getString( solver, "reference", "", ctx ) );
+  sim.analyticProjection = getBool( solver, "analyticProjection", sim.analyticProjection, ctx );
+  sim.subtract_reference = getBool( solver, "subtractReference", sim.subtract_reference, ctx );
+  sim.supressMessages = getBool( solver, "supressMessages", sim.supressMessages, ctx );
+  sim.fftwWisdomFile = getString( solver, "wisdomFile", sim.fftwWisdomFile, ctx );
+  sim.setNumberOfThreads( getUint( solver, "threads", 0, ctx ) );
+}
+
+void SceneRunner::readMaterial( const Json::Value &mat )
+{
+  const string ctx("material");
+  checkKeys( mat, {"deltaSurrounding", "betaSurrounding", "modules"}, ctx );
+  material = new CSGMaterial();
+  material->deltaSurrounding = getDouble( mat, "deltaSurrounding", 0.0, ctx );
+  material->betaSurrounding = getDouble( mat, "betaSurrounding", 0.0, ctx );
+
+  const Json::Value &moduleList = required( mat, "modules", ctx );
+  if ( !moduleList.isArray() || ( moduleList.size() == 0 ) )
+  {
+    throw( runtime_error("The modules of the material has to be a non-empty array!") );
+  }
+  for ( unsigned int i=0;i<moduleList.size();i++ )
+  {
+    material->addModule( *createModule( moduleList[i] ) );
+  }
+  simulation->setMaterial( *material );
+}
+
+geom::Module* SceneRunner::createModule( const Json::Value &obj )
+{
+  const string ctx("module");
+  checkKeys( obj, {"name", "parts", "transforms"}, ctx );
+  string name = getString( obj, "name", "module", ctx );
+  geom::Module *module = new geom::Module( name.c_str() );
+  modules.push_back( module );
+
+  const Json::Value &partList = required( obj, "parts", ctx );
+  for ( unsigned int i=0;i<partList.size();i++ )
+  {
+    geom::Part *part = createPart( partList[i] );
+    string operation = lowerCase( getString( partList[i], "operation", "union", "part" ) );
+    if ( operation == "union" )
+    {
+      module->add( *part );
+    }
+    else if ( operation == "difference" )
+    {
+      module->difference( *part );
+    }
+    else
+    {
+      throw( runtime_error("Unknown operation "+operation+" in module "+name+"!") );
+    }
+  }
+
+  if ( obj.isMember("transforms") ) applyTransforms( obj["transforms"], *module );
+  return module;
+}
+
+geom::Part* SceneRunner::createPart( const Json::Value &obj )
+{
+  const string ctx("part");
+  checkKeys( obj, {"name", "delta", "beta", "operation", "shapes", "transforms"}, ctx );
+  string name = getString( obj, "name", "part", ctx );
+  geom::Part *part = new geom::Part( name.c_str() );
+  parts.push_back( part );
+  part->delta = getDouble( obj, "delta", 0.0, ctx );
+  part->beta = getDouble( obj, "beta", 0.0, ctx );
+
+  const Json::Value &shapeList = required( obj, "shapes", ctx );
+  for ( unsigned int i=0;i<shapeList.size();i++ )
+  {
+    geom::Shape *shape = createShape( shapeList[i] );
+    string operation = lowerCase( getString( shapeList[i], "operation", "union", "shape" ) );
+    if ( operation == "union" )
+    {
+      part->add( *shape );
+    }
+    else if ( operation == "difference" )
+    {
+      part->difference( *shape );
+    }
+    else
+    {
+      throw( runtime_error("Unknown operation "+operation+" in part "+name+"!") );
+    }
+  }
+
+  if ( obj.isMember("transforms") ) applyTransforms( obj["transforms"], *part );
+  return part;
+}
+
+geom::Shape* SceneRunner::createShape( const Json::Value &obj )
+{
+  const string ctx("shape");
+  checkKeys( obj, {"type", "radius", "r1", "r2", "height", "Lx", "Ly", "Lz", "operation", "transforms"}, ctx );
+  string type = lowerCase( getString( required( obj, "type", ctx ), NULL, "", ctx ) );
+
+  geom::Shape *shape = NULL;
+  if ( type == "sphere" )
+  {
+    shape = new geom::Sphere( getDouble( required( obj, "radius", ctx ), NULL, 0.0, ctx ) );
+  }
+  else if ( type == "box" )
+  {
+    shape = new geom::Box( getDouble( required( obj, "Lx", ctx ), NULL, 0.0, ctx ),
+                           getDouble( required( obj, "Ly", ctx ), NULL, 0.0, ctx ),
+                           getDouble( required( obj, "Lz", ctx ), NULL, 0.0, ctx ) );
+  }
+  else if ( type == "cylinder" )
+  {
+    double height = getDouble( required( obj, "height", ctx ), NULL, 0.0, ctx );
+    if ( obj.isMember("radius") )
+    {
+      shape = new geom::Cylinder( getDouble( obj, "radius", 0.0, ctx ), height );
+    }
+    else
+    {
+      shape = new geom::Cylinder( getDouble( required( obj, "r1", ctx ), NULL, 0.0, ctx ),
+                                  getDouble( required( obj, "r2", ctx ), NULL, 0.0, ctx ), height );
+    }
+  }
+  else
+  {
+    throw( runtime_error("Unknown shape "+type+". Has to be sphere, box or cylinder!") );
+  }
+  shapes.push_back( shape );
+
+  if ( obj.isMember("transforms") ) applyTransforms( obj["transforms"], *shape );
+  return shape;
+}
+
+template<class T>
+void SceneRunner::applyTransforms( const Json::Value &transforms, T &object )
+{
+  const string ctx("transform");
+  if ( !transforms.isArray() )
+  {
+    throw( runtime_error("The transforms has to be an array!") );
+  }
+
+  // The transformations are applied in the order they are listed
+  for ( unsigned int i=0;i<transforms.size();i++ )
+  {
+    const Json::Value &trans = transforms[i];
+    checkKeys( trans, {"type", "x", "y", "z", "angle", "factor", "axis"}, ctx );
+    string type = lowerCase( getString( trans, "type", "", ctx ) );
+    if ( type == "translate" )
+    {
+      object.translate( getDouble( trans, "x", 0.0, ctx ), getDouble( trans, "y", 0.0, ctx ), getDouble( trans, "z", 0.0, ctx ) );
+    }
+    else if ( type == "rotate" )
+    {
+      object.rotate( getDouble( required( trans, "angle", ctx ), NULL, 0.0, ctx ),
+                     axisFromString( getString( required( trans, "axis", ctx ), NULL, "", ctx ) ) );
+    }
+    else if ( type == "scale" )
+    {
+      object.scale( getDouble( required( trans, "factor", ctx ), NULL, 0.0, ctx ),
+                    axisFromString( getString( required( trans, "axis", ctx ), NULL, "", ctx ) ) );
+    }
+    else
+    {
+      throw( runtime_error("Unknown transform "+type+". Has to be translate, rotate or scale!") );
+    }
+  }
+}
+
+void SceneRunner::readPostProcessing( const Json::Value &moduleList )
+{
+  const string ctx("postProcessing");
+  if ( !moduleList.isArray() )
+  {
+    throw( runtime_error("postProcessing has to be an array!") );
+  }
+
+  // Exit field, exit intensity, exit phase and far field are always stored by GenericScattering
+  for ( unsigned int i=0;i<moduleList.size();i++ )
+  {
+    const Json::Value &obj = moduleList[i];
+    checkKeys( obj, {"type", "min", "max", "exportNx", "exportNy"}, ctx );
+    string type = lowerCase( getString( obj, "type", "", ctx ) );
+    post::PostProcessingModule *ppm = NULL;
+    if ( type == "intensity" )
+    {
+      ppm = new post::Intensity();
+    }
+    else if ( type == "intensityuint8" )
+    {
+      ppm = new post::IntensityUint8();
+    }
+    else if ( type == "logintensityuint8" )
+    {
+      post::LogIntensityUint8 *logInt = new post::LogIntensityUint8();
+      if ( obj.isMember("min") ) logInt->setMinValue( getDouble( obj, "min", 0.0, ctx ) );
+      if ( obj.isMember("max") ) logInt->setMaxValue( getDouble( obj, "max", 0.0, ctx ) );
+      ppm = logInt;
+    }
+    else if ( type == "phase" )
+    {
+      ppm = new post::Phase();
+    }
+    else
+    {
+      throw( runtime_error("Unknown post processing module "+type+"!") );
+    }
+    postProcess.push_back( ppm );
+
+    if ( obj.isMember("exportNx") || obj.isMember("exportNy") )
+    {
+      ppm->setExportDimensions( getUint( obj, "exportNx", simulation->exportNx, ctx ), getUint( obj, "exportNy", simulation->exportNy, ctx ) );
+    }
+    simulation->addPostProcessing( *ppm );
+  }
+}
+
+void SceneRunner::readScan( const Json::Value &scan )
+{
+  const string ctx("scan");
+  checkKeys( scan, {"module", "points"}, ctx );
+  scanModule = getUint( scan, "module", 0, ctx );
+  if ( scanModule >= modules.size() )
+  {
+    throw( runtime_error("The scan module index exceeds the number of modules!") );
+  }
+
+  const Json::Value &pointList = required( scan, "points", ctx );
+  for ( unsigned int i=0;i<pointList.size();i++ )
+  {
+    const Json::Value &obj = pointList[i];
+    checkKeys( obj, {"angle", "axis", "x", "y", "z"}, "scan point" );
+    ScanPoint point;
+    point.angleDeg = getDouble( obj, "angle", 0.0, ctx );
+    point.axis = axisFromString( getString( obj, "axis", "y", ctx ) );
+    point.x = getDouble( obj, "x", 0.0, ctx );
+    point.y = getDouble( obj, "y", 0.0, ctx );
+    point.z = getDouble( obj, "z", 0.0, ctx );
+    scanPoints.push_back( point );
+  }
+
+  if ( scanPoints.empty() )
+  {
+    throw( runtime_error("The scan has no points!") );
+  }
+}
+
+void SceneRunner::run()
+{
+  GenericScattering &sim = getSimulation();
+  if ( hasScan() )
+  {
+    // The scan writes its own file
+    sim.scan( *modules[scanModule], scanPoints, outputFile.c_str() );
+    return;
+  }
+  sim.solve();
+  sim.save( outputFile );
+}
+
+GenericScattering& SceneRunner::getSimulation()
+{
+  if ( simulation == NULL )
+  {
+    throw( runtime_error("No scene has been loaded!") );
+  }
+  return *simulation;
+}
+
+void SceneRunner::checkKeys( const Json::Value &obj, const vector<string> &known, const string &context )
+{
+  if ( !obj.isObject() )
+  {
+    throw( runtime_error("Expected a JSON object in "+context+"!") );
+  }
+
+  Json::Value::Members keys = obj.getMemberNames();
+  for ( unsigned int i=0;i<keys.size();i++ )
+  {
+    if ( find( known.begin(), known.end(), keys[i] ) == known.end() )
+    {
+      clog << "Warning! Unknown key " << keys[i] << " in " << context << " is ignored\n";
+    }
+  }
+}
+
+const Json::Value& SceneRunner::required( const Json::Value &obj, const char* key, const string &context )
+{
+  if ( !obj.isMember( key ) )
+  {
+    throw( runtime_error("The key "+string(key)+" is required in "+context+"!") );
+  }
+  return obj[key];
+}
+
+double SceneRunner::getDouble( const Json::Value &obj, const char* key, double defaultValue, const string &context )
+{
+  // If key is NULL the value itself is converted
+  if (( key != NULL ) && !obj.isMember( key )) return defaultValue;
+  const Json::Value &value = ( key == NULL ) ? obj:obj[key];
+  if ( !value.isNumeric() )
+  {
+    throw( runtime_error("Expected a number for "+string(key == NULL ? "value":key)+" in "+context+"!") );
+  }
+  return value.asDouble();
+}
+
+unsigned int SceneRunner::getUint( const Json::Value &obj, const char* key, unsigned int defaultValue, const string &context )
+{
+  if ( !obj.isMember( key ) ) return defaultValue;
+  if ( !obj[key].isUInt() )
+  {
+    throw( runtime_error("Expected a non-negative integer for "+string(key)+" in "+context+"!") );
+  }
+  return obj[key].asUInt();
+}
+
+bool SceneRunner::getBool( const Json::Value &obj, const char* key, bool defaultValue, const string &context )
+{
+  if ( !obj.isMember( key ) ) return defaultValue;
+  if ( !obj[key].isBool() )
+  {
+    throw( runtime_error("Expected true or false for "+string(key)+" in "+context+"!") );
+  }
+  return obj[key].asBool();
+}
+
+string SceneRunner::getString( const Json::Value &obj, const char* key, const string &defaultValue, const string &context )
+{
+  if (( key != NULL ) && !obj.isMember( key )) return defaultValue;
+  const Json::Value &value = ( key == NULL ) ? obj:obj[key];
+  if ( !value.isString() )
+  {
+    throw( runtime_error("Expected a string for "+string(key == NULL ? "value":key)+" in "+context+"!") );
+  }
+  return value.asString();
+}
+
+geom::Axis_t SceneRunner::axisFromString( const string &name )
+{
+  string lower = lowerCase( name );
+  if ( lower == "x" ) return geom::Axis_t::X;
+  if ( lower == "y" ) return geom::Axis_t::Y;
+  if ( lower == "z" ) return geom::Axis_t::Z;
+  throw( runtime_error("Unknown axis "+name+". Has to be x, y or z!") );
+}
+
+GenericScattering::SolverType_t SceneRunner::solverFromString( const string &name )
+{
+  typedef GenericScattering::SolverType_t solver_t;
+  string lower = lowerCase( name );
+  if ( lower == "adi" ) return solver_t::ADI;
+  if ( lower == "fft" ) return solver_t::FFT;
+  if ( lower == "proj" ) return solver_t::PROJ;
+  if ( lower == "hankel" ) return solver_t::HANKEL;
+  throw( runtime_error("Unknown solver "+name+". Has to be ADI, FFT, PROJ or HANKEL!") );
+}
+
+GenericScattering::Reference_t SceneRunner::referenceFromString( const string &name )
+{
+  typedef GenericScattering::Reference_t ref_t;
+  string lower = lowerCase( name );
+  if ( lower == "propagate" ) return ref_t::PROPAGATE;
+  if ( lower == "analytic" ) return ref_t::ANALYTIC;
+  if ( lower == "cached" ) return ref_t::CACHED;
+  throw( runtime_error("Unknown reference mode "+name+". Has to be PROPAGATE, ANALYTIC or CACHED!") );
+}
+
+Splitting_t SceneRunner::splittingFromString( const string &name )
+{
+  string lower = lowerCase( name );
+  if ( lower == "lie" ) return Splitting_t::LIE;
+  if ( lower == "strang" ) return Splitting_t::STRANG;
+  throw( runtime_error("Unknown splitting "+name+". Has to be LIE or STRANG!") );
+}
+
+Precision_t SceneRunner::precisionFromString( const string &name )
+{
+  string lower = lowerCase( name );
+  if ( lower == "double" ) return Precision_t::DOUBLE;
+  if ( lower == "single" ) return Precision_t::SINGLE;
+  throw( runtime_error("Unknown precision "+name+". Has to be DOUBLE or SINGLE!") );
+}
+
+PlanRigor_t SceneRunner::rigorFromString( const string &name )
+{
+  string lower = lowerCase( name );
+  if ( lower == "estimate" ) return PlanRigor_t::ESTIMATE;
+  if ( lower == "measure" ) return PlanRigor_t::MEASURE;
+  if ( lower == "patient" ) return PlanRigor_t::PATIENT;
+  throw( runtime_error("Unknown plan rigor "+name+". Has to be ESTIMATE, MEASURE or PATIENT!") );
+}
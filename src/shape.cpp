@@ -2,11 +2,62 @@
 #include <cmath>
 #include <sstream>
 #include <cassert>
+#include <limits>
 
 using namespace std;
 
 using namespace std;
 
+/**
+* Restricts [lo,hi] to where a*t^2 + b*t + c < 0. All shapes are convex, so the result is a single interval.
+* Returns false if it is empty
+*/
+static bool restrictToNegative( double a, double b, double c, double &lo, double &hi )
+{
+  if ( a == 0.0 )
+  {
+    if ( b == 0.0 ) return ( c < 0.0 ) && ( lo < hi );
+    double root = -c/b;
+    if ( b > 0.0 ) hi = hi < root ? hi:root;
+    else lo = lo > root ? lo:root;
+    return lo < hi;
+  }
+
+  double disc = b*b - 4.0*a*c;
+  if ( disc <= 0.0 )
+  {
+    // The polynomial does not change sign
+    return ( a < 0.0 ) && ( lo < hi );
+  }
+
+  // Numerically stable roots, also when a is small
+  double sqrtDisc = sqrt(disc);
+  double q = ( b >= 0.0 ) ? -0.5*( b+sqrtDisc ):-0.5*( b-sqrtDisc );
+  double t1 = q/a;
+  double t2 = c/q;
+  if ( t1 > t2 ) swap( t1, t2 );
+
+  if ( a > 0.0 )
+  {
+    lo = lo > t1 ? lo:t1;
+    hi = hi < t2 ? hi:t2;
+    return lo < hi;
+  }
+
+  // Negative outside the roots. Only one side can overlap [lo,hi] for a convex shape
+  double hiLeft = hi < t1 ? hi:t1;
+  double loRight = lo > t2 ? lo:t2;
+  if ( hiLeft-lo >= hi-loRight )
+  {
+    hi = hiLeft;
+  }
+  else
+  {
+    lo = loRight;
+  }
+  return lo < hi;
+}
+
 geom::Shape::Shape( const char* name ): name(name)
 {
   transformation.set_size(4,4);
@@ -108,6 +159,16 @@ void geom::Shape::getInverseTransformation( arma::mat &inverse ) const
   }*/
 }
 
+void geom::Shape::localLine( double x, double y, double origin[3], double direction[3] ) const
+{
+  // The shape coordinates are an affine function of z, so z can be used as the line parameter
+  for ( unsigned int i=0;i<3;i++ )
+  {
+    origin[i] = transformation(i,0)*x + transformation(i,1)*y + transformation(i,3);
+    direction[i] = transformation(i,2);
+  }
+}
+
 void geom::Shape::inverseTransform( double &x, double &y, double &z ) const
 {
   arma::mat inverse;
@@ -150,6 +211,18 @@ bool geom::Sphere::isInside( double x, double y, double z ) const
   return r < radius;
 }
 
+bool geom::Sphere::zInterval( double x, double y, double &zEnter, double &zExit ) const
+{
+  double o[3], d[3];
+  localLine( x, y, o, d );
+  double a = d[0]*d[0] + d[1]*d[1] + d[2]*d[2];
+  double b = 2.0*( o[0]*d[0] + o[1]*d[1] + o[2]*d[2] );
+  double c = o[0]*o[0] + o[1]*o[1] + o[2]*o[2] - radius*radius;
+  zEnter = -numeric_limits<double>::infinity();
+  zExit = numeric_limits<double>::infinity();
+  return restrictToNegative( a, b, c, zEnter, zExit );
+}
+
 void geom::Sphere::openSCADDescription( std::string &description ) const
 {
   stringstream ss;
@@ -164,6 +237,30 @@ bool geom::Box::isInside( double x, double y, double z ) const
   return ( x > -Lx/2.0 ) && ( x < Lx/2.0 ) && ( y > -Ly/2.0 ) && ( y < Ly/2.0 ) && ( z > -Lz/2.0 ) && ( z < Lz/2.0 );
 }
 
+bool geom::Box::zInterval( double x, double y, double &zEnter, double &zExit ) const
+{
+  double o[3], d[3];
+  localLine( x, y, o, d );
+  double halfLength[3] = {0.5*Lx, 0.5*Ly, 0.5*Lz};
+  zEnter = -numeric_limits<double>::infinity();
+  zExit = numeric_limits<double>::infinity();
+  for ( unsigned int i=0;i<3;i++ )
+  {
+    if ( d[i] == 0.0 )
+    {
+      // Parallel to the faces
+      if (( o[i] <= -halfLength[i] ) || ( o[i] >= halfLength[i] )) return false;
+      continue;
+    }
+    double t1 = ( -halfLength[i]-o[i] )/d[i];
+    double t2 = ( halfLength[i]-o[i] )/d[i];
+    if ( t1 > t2 ) swap( t1, t2 );
+    zEnter = zEnter > t1 ? zEnter:t1;
+    zExit = zExit < t2 ? zExit:t2;
+  }
+  return zEnter < zExit;
+}
+
 void geom::Box::openSCADDescription( std::string &description ) const
 {
   stringstream ss ;
@@ -186,6 +283,35 @@ bool geom::Cylinder::isInside( double x, double y, double z ) const
   return r < radius;
 }
 
+bool geom::Cylinder::zInterval( double x, double y, double &zEnter, double &zExit ) const
+{
+  double o[3], d[3];
+  localLine( x, y, o, d );
+
+  // End faces
+  zEnter = -numeric_limits<double>::infinity();
+  zExit = numeric_limits<double>::infinity();
+  if ( d[2] == 0.0 )
+  {
+    if (( o[2] <= -0.5*height ) || ( o[2] >= 0.5*height )) return false;
+  }
+  else
+  {
+    zEnter = ( -0.5*height-o[2] )/d[2];
+    zExit = ( 0.5*height-o[2] )/d[2];
+    if ( zEnter > zExit ) swap( zEnter, zExit );
+  }
+
+  // Conical surface x^2 + y^2 = R^2, where the radius R = R0 + R1*t is linear along the line
+  double slope = ( r2-r1 )/height;
+  double R0 = r1 + slope*( o[2]+0.5*height );
+  double R1 = slope*d[2];
+  double a = d[0]*d[0] + d[1]*d[1] - R1*R1;
+  double b = 2.0*( o[0]*d[0] + o[1]*d[1] - R0*R1 );
+  double c = o[0]*o[0] + o[1]*o[1] - R0*R0;
+  return restrictToNegative( a, b, c, zEnter, zExit );
+}
+
 void geom::Cylinder::openSCADDescription( string &description ) const
 {
   stringstream ss;
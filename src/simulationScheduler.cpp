@@ -0,0 +1,374 @@
+#include "simulationScheduler.hpp"
+#include "paraxialSimulation.hpp"
+#include <omp.h>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#ifdef __linux__
+  #include <sched.h>
+#endif
+
+using namespace std;
+
+void SimulationScheduler::add( ParaxialSimulation &sim, const string &fname )
+{
+  Job job;
+  job.sim = &sim;
+  job.fname = fname;
+  jobs.push_back( job );
+}
+
+unsigned int SimulationScheduler::run()
+{
+  if ( jobs.empty() ) return 0;
+
+  activeAffinity = affinity;
+  if (( activeAffinity != Affinity_t::NONE ) && ( omp_get_proc_bind() != omp_proc_bind_false ))
+  {
+    clog << "Warning! OMP_PROC_BIND is set, the placement of the threads is left to the OpenMP runtime\n";
+    activeAffinity = Affinity_t::NONE;
+  }
+
+  // The threads are restored to the CPUs of the calling thread when a job is finished
+  processCpus = availableCpus();
+
+  unsigned int nSlots = 0;
+  unsigned int nThreads = 0;
+  setupSlots( nSlots, nThreads );
+  clog << "Running " << jobs.size() << " jobs, " << nSlots << " at a time with " << nThreads << " threads each\n";
+
+  for ( unsigned int i=0;i<jobs.size();i++ )
+  {
+    jobs[i].finished = false;
+    jobs[i].failed = false;
+    jobs[i].error = "";
+  }
+
+  // Each job is run by one thread in the outer team, which spawns a nested team for the solver
+  int prevLevels = omp_get_max_active_levels();
+  int prevDynamic = omp_get_dynamic();
+  omp_set_max_active_levels( 2 );
+  omp_set_dynamic( 0 );
+
+  #pragma omp parallel num_threads(nSlots)
+  {
+    unsigned int slot = omp_get_thread_num();
+    omp_set_num_threads( nThreads );
+
+    #pragma omp for schedule(dynamic,1)
+    for ( unsigned int i=0;i<jobs.size();i++ )
+    {
+      runJob( jobs[i], slot, nThreads );
+    }
+  }
+
+  omp_set_max_active_levels( prevLevels );
+  omp_set_dynamic( prevDynamic );
+
+  unsigned int nFailed = 0;
+  for ( unsigned int i=0;i<jobs.size();i++ )
+  {
+    if ( jobs[i].failed ) nFailed++;
+  }
+  return nFailed;
+}
+
+void SimulationScheduler::runJob( Job &job, unsigned int slot, unsigned int nThreads )
+{
+  job.slot = slot;
+  if ( activeAffinity != Affinity_t::NONE )
+  {
+    // OpenMP does not guarantee that the nested regions of the solver run on the threads bound here.
+    // The common runtimes keep one pool of threads per outer thread, so in practice they do.
+    // OMP_PLACES and OMP_PROC_BIND gives a guaranteed placement
+    #pragma omp parallel num_threads(nThreads)
+    {
+      bindThread( threadCpus( slot, omp_get_thread_num() ) );
+    }
+  }
+
+  double start = omp_get_wtime();
+  try
+  {
+    job.sim->solve();
+    if ( job.fname != "" )
+    {
+      // The HDF5 library is not thread safe
+      #pragma omp critical(paxproHDF5)
+      {
+        job.sim->save( job.fname );
+      }
+    }
+  }
+  catch ( exception &exc )
+  {
+    job.failed = true;
+    job.error = exc.what();
+  }
+  catch ( ... )
+  {
+    job.failed = true;
+    job.error = "Unknown exception";
+  }
+  job.wallTime = omp_get_wtime()-start;
+  job.finished = true;
+
+  // Thread 0 of the nested team is the calling thread, so it is restored as well
+  if ( activeAffinity != Affinity_t::NONE )
+  {
+    #pragma omp parallel num_threads(nThreads)
+    {
+      bindThread( processCpus );
+    }
+  }
+}
+
+void SimulationScheduler::setupSlots( unsigned int &nSlots, unsigned int &nThreads )
+{
+  vector<int> cpus = availableCpus();
+  unsigned int nCpus = cpus.size();
+  vector< vector<int> > nodes;
+  if ( activeAffinity == Affinity_t::NUMA )
+  {
+    nodes = numaNodes();
+
+    // Only the CPUs the process may use are kept
+    for ( unsigned int i=0;i<nodes.size(); )
+    {
+      vector<int> allowed;
+      for ( unsigned int j=0;j<nodes[i].size();j++ )
+      {
+        if ( find( cpus.begin(), cpus.end(), nodes[i][j] ) != cpus.end() ) allowed.push_back( nodes[i][j] );
+      }
+      if ( allowed.empty() )
+      {
+        nodes.erase( nodes.begin()+i );
+        continue;
+      }
+      nodes[i] = allowed;
+      i++;
+    }
+
+    if ( nodes.empty() )
+    {
+      clog << "Warning! Could not read the NUMA topology. Binding the threads to cores instead\n";
+      activeAffinity = Affinity_t::CORES;
+    }
+  }
+
+  nSlots = concurrentJobs;
+  if ( nSlots == 0 )
+  {
+    if ( activeAffinity == Affinity_t::NUMA )
+    {
+      nSlots = nodes.size();
+    }
+    else if ( threadsPerJob > 0 )
+    {
+      nSlots = nCpus/threadsPerJob;
+    }
+    else
+    {
+      nSlots = nCpus;
+    }
+  }
+  if ( nSlots > jobs.size() ) nSlots = jobs.size();
+  if ( nSlots == 0 ) nSlots = 1;
+
+  nThreads = threadsPerJob;
+  if ( nThreads == 0 )
+  {
+    if ( activeAffinity == Affinity_t::NUMA )
+    {
+      nThreads = nodes[0].size();
+      for ( unsigned int i=1;i<nodes.size();i++ )
+      {
+        nThreads = nodes[i].size() < nThreads ? nodes[i].size():nThreads;
+      }
+      if ( nSlots > nodes.size() ) nThreads = nThreads*nodes.size()/nSlots;
+    }
+    else
+    {
+      nThreads = nCpus/nSlots;
+    }
+  }
+  if ( nThreads == 0 ) nThreads = 1;
+
+  if ( nSlots*nThreads > nCpus )
+  {
+    clog << "Warning! " << nSlots << " jobs with " << nThreads << " threads each oversubscribes the " << nCpus << " cores\n";
+  }
+
+  slotCpus.resize( nSlots );
+  for ( unsigned int i=0;i<nSlots;i++ )
+  {
+    slotCpus[i].clear();
+    if ( activeAffinity == Affinity_t::NUMA )
+    {
+      slotCpus[i] = nodes[i%nodes.size()];
+    }
+    else
+    {
+      for ( unsigned int j=0;j<nThreads;j++ )
+      {
+        slotCpus[i].push_back( cpus[(i*nThreads+j)%nCpus] );
+      }
+    }
+  }
+}
+
+vector<int> SimulationScheduler::threadCpus( unsigned int slot, unsigned int thread ) const
+{
+  const vector<int> &slotSet = slotCpus[slot];
+  if ( activeAffinity == Affinity_t::CORES )
+  {
+    return vector<int>( 1, slotSet[thread%slotSet.size()] );
+  }
+  return slotSet;
+}
+
+bool SimulationScheduler::bindThread( const vector<int> &cpus )
+{
+  #ifdef __linux__
+    cpu_set_t mask;
+    CPU_ZERO( &mask );
+    for ( unsigned int i=0;i<cpus.size();i++ )
+    {
+      CPU_SET( cpus[i], &mask );
+    }
+    return sched_setaffinity( 0, sizeof(cpu_set_t), &mask ) == 0;
+  #else
+    static bool warningPrinted = false;
+    #pragma omp critical(schedulerWarning)
+    {
+      if ( !warningPrinted )
+      {
+        clog << "Warning! Thread binding is only supported on Linux. Use OMP_PLACES and OMP_PROC_BIND instead\n";
+        warningPrinted = true;
+      }
+    }
+    return false;
+  #endif
+}
+
+vector<int> SimulationScheduler::availableCpus()
+{
+  vector<int> cpus;
+  #ifdef __linux__
+    cpu_set_t mask;
+    CPU_ZERO( &mask );
+    if ( sched_getaffinity( 0, sizeof(cpu_set_t), &mask ) == 0 )
+    {
+      for ( int i=0;i<CPU_SETSIZE;i++ )
+      {
+        if ( CPU_ISSET( i, &mask ) ) cpus.push_back( i );
+      }
+    }
+  #endif
+
+  if ( cpus.empty() )
+  {
+    for ( int i=0;i<omp_get_num_procs();i++ )
+    {
+      cpus.push_back( i );
+    }
+  }
+  return cpus;
+}
+
+vector< vector<int> > SimulationScheduler::numaNodes()
+{
+  vector< vector<int> > nodes;
+  for ( unsigned int node=0;;node++ )
+  {
+    stringstream fname;
+    fname << "/sys/devices/system/node/node" << node << "/cpulist";
+    ifstream in( fname.str().c_str() );
+    if ( !in.good() ) break;
+
+    string list;
+    getline( in, list );
+    nodes.push_back( parseCpuList( list ) );
+  }
+  return nodes;
+}
+
+vector<int> SimulationScheduler::parseCpuList( const string &list )
+{
+  vector<int> cpus;
+  stringstream ss( list );
+  string range;
+  while ( getline( ss, range, ',' ) )
+  {
+    if ( range.find_first_of( "0123456789" ) == string::npos ) continue;
+
+    int first = 0;
+    int last = 0;
+    size_t dash = range.find( '-' );
+    if ( dash == string::npos )
+    {
+      first = stoi( range );
+      last = first;
+    }
+    else
+    {
+      first = stoi( range.substr( 0, dash ) );
+      last = stoi( range.substr( dash+1 ) );
+    }
+
+    for ( int cpu=first;cpu<=last;cpu++ )
+    {
+      cpus.push_back( cpu );
+    }
+  }
+  return cpus;
+}
+
+const SimulationScheduler::Job& SimulationScheduler::getJob( unsigned int job ) const
+{
+  if ( job >= jobs.size() )
+  {
+    throw( out_of_range("Job index exceeds the number of jobs!") );
+  }
+  return jobs[job];
+}
+
+bool SimulationScheduler::succeeded( unsigned int job ) const
+{
+  const Job &stored = getJob( job );
+  return stored.finished && !stored.failed;
+}
+
+const string& SimulationScheduler::getError( unsigned int job ) const
+{
+  return getJob( job ).error;
+}
+
+double SimulationScheduler::getWallTime( unsigned int job ) const
+{
+  return getJob( job ).wallTime;
+}
+
+unsigned int SimulationScheduler::getSlot( unsigned int job ) const
+{
+  return getJob( job ).slot;
+}
+
+void SimulationScheduler::printSummary() const
+{
+  for ( unsigned int i=0;i<jobs.size();i++ )
+  {
+    cout << i << ": " << jobs[i].sim->getName() << " slot " << jobs[i].slot << " " << jobs[i].wallTime << " s";
+    if ( jobs[i].failed )
+    {
+      cout << " FAILED: " << jobs[i].error;
+    }
+    else if ( !jobs[i].finished )
+    {
+      cout << " not run";
+    }
+    cout << endl;
+  }
+}
@@ -4,6 +4,7 @@
 #include <complex>
 #include <stdexcept>
 #include <iostream>
+#include <cmath>
 
 using namespace std;
 
@@ -121,6 +122,13 @@ void Solver2D::realOrImagPart( double *compsolution, Comp_t comp ) const
 void Solver2D::fillInfo( Json::Value &obj ) const
 {
   obj["name"] = name;
+  if ( adaptive.enabled )
+  {
+    obj["adaptiveTolerance"] = adaptive.tolerance;
+    obj["adaptiveMinStep"] = adaptive.minStep;
+    obj["acceptedSubsteps"] = adaptive.nAccepted;
+    obj["rejectedSubsteps"] = adaptive.nRejected;
+  }
 }
 
 bool Solver2D::importHDF5( const string &fname )
@@ -244,11 +252,136 @@ void Solver2D::step()
 {
   if ( currentStep == 1 ) initValuesFromWaveGuide();
 
-  solveStep( currentStep );
+  stepStartZ = zmin + static_cast<double>(currentStep-1)*stepZ;
+  if ( adaptive.enabled )
+  {
+    adaptiveStep();
+  }
+  else
+  {
+    solveStep( currentStep );
+  }
   copyCurrentSolution( currentStep );
   currentStep++;
 }
 
+void Solver2D::setAdaptiveStepping( double tolerance, double minStep )
+{
+  if (( tolerance <= 0.0 ) || ( minStep <= 0.0 ))
+  {
+    throw( invalid_argument("The tolerance and the minimum step of the adaptive stepping has to be positive!") );
+  }
+  adaptive.enabled = true;
+  adaptive.tolerance = tolerance;
+  adaptive.minStep = minStep;
+}
+
+void Solver2D::adaptiveStep()
+{
+  double gridStep = stepZ;
+  double zGrid = stepStartZ + gridStep;
+  if ( currentStep == 1 )
+  {
+    adaptive.step = 0.0;
+    adaptive.nAccepted = 0;
+    adaptive.nRejected = 0;
+    adaptiveAhead = *prevSolution;
+    adaptive.zAhead = stepStartZ;
+  }
+
+  // The substeps land on every downsamplingRatio grid plane and on the last one
+  const double zTol = 1E-9*gridStep;
+  if ( adaptive.zAhead < zGrid-zTol )
+  {
+    unsigned int ratio = guide->longitudinalDiscretization().downsamplingRatio;
+    if ( ratio == 0 ) ratio = 1;
+    unsigned int landing = ( ( currentStep+ratio-1 )/ratio )*ratio;
+    landing = landing > Nz-1 ? Nz-1:landing;
+
+    adaptiveBehind = adaptiveAhead;
+    adaptive.zBehind = adaptive.zAhead;
+    *prevSolution = adaptiveAhead;
+    integrateAdaptive( adaptive.zAhead, zmin+landing*gridStep, ratio*gridStep );
+    adaptiveAhead = *currentSolution;
+    adaptive.zAhead = zmin+landing*gridStep;
+    stepZ = gridStep;
+  }
+
+  // The grid planes between the landing planes are interpolated linearly
+  if ( abs( adaptive.zAhead-zGrid ) <= zTol )
+  {
+    *currentSolution = adaptiveAhead;
+  }
+  else
+  {
+    double weight = ( zGrid-adaptive.zBehind )/( adaptive.zAhead-adaptive.zBehind );
+    *currentSolution = ( 1.0-weight )*adaptiveBehind + weight*adaptiveAhead;
+  }
+  stepStartZ = zGrid-gridStep;
+}
+
+void Solver2D::integrateAdaptive( double zStart, double zEnd, double maxStep )
+{
+  const double SAFETY = 0.9;
+  const double MIN_FACTOR = 0.2;
+  const double MAX_FACTOR = 5.0;
+
+  double z = zStart;
+  if (( adaptive.step <= 0.0 ) || ( adaptive.step > maxStep )) adaptive.step = maxStep;
+
+  // The error of the two half steps is (half - full)/(2^p-1) to leading order
+  double errorScale = 1.0/( pow( 2.0, orderOfAccuracy() ) - 1.0 );
+  double exponent = 1.0/( orderOfAccuracy()+1.0 );
+
+  while ( zEnd-z > 1E-9*maxStep )
+  {
+    // The last substep is shortened to land on the plane
+    bool isTruncated = ( z+adaptive.step >= zEnd );
+    double h = isTruncated ? zEnd-z:adaptive.step;
+    adaptiveStart = *prevSolution;
+
+    // One full step
+    stepZ = h;
+    stepStartZ = z;
+    solveStep( currentStep );
+    adaptiveFullStep = *currentSolution;
+
+    // Two half steps. Some solvers use the previous solution as scratch array
+    *prevSolution = adaptiveStart;
+    stepZ = 0.5*h;
+    solveStep( currentStep );
+    *prevSolution = *currentSolution;
+    stepStartZ = z+0.5*h;
+    solveStep( currentStep );
+
+    double normHalf = arma::norm( *currentSolution );
+    double error = ( normHalf > 0.0 ) ? errorScale*arma::norm( *currentSolution-adaptiveFullStep )/normHalf:0.0;
+    double factor = ( error > 0.0 ) ? SAFETY*pow( adaptive.tolerance/error, exponent ):MAX_FACTOR;
+    factor = factor < MIN_FACTOR ? MIN_FACTOR:factor;
+    factor = factor > MAX_FACTOR ? MAX_FACTOR:factor;
+
+    bool accept = ( error <= adaptive.tolerance ) || ( h <= adaptive.minStep );
+    if ( accept )
+    {
+      z += h;
+      *prevSolution = *currentSolution;
+      adaptive.nAccepted++;
+
+      // A truncated step says nothing about whether the proposed step is too long
+      double proposal = h*factor;
+      if ( !isTruncated || ( proposal > adaptive.step ) ) adaptive.step = proposal;
+    }
+    else
+    {
+      *prevSolution = adaptiveStart;
+      adaptive.nRejected++;
+      adaptive.step = h*factor;
+    }
+    adaptive.step = adaptive.step < adaptive.minStep ? adaptive.minStep:adaptive.step;
+    adaptive.step = adaptive.step > maxStep ? maxStep:adaptive.step;
+  }
+}
+
 void Solver2D::initValuesFromWaveGuide()
 {
   if ( guide == nullptr )
@@ -21,9 +21,10 @@ void Solver3D::setSimulator( ParaxialSimulation &sim )
   Solver::setSimulator( sim );
   Nx = guide->nodeNumberTransverse();
   Nz = guide->nodeNumberLongitudinal();
-  Ny = Nx;
+  Ny = guide->nodeNumberVertical();
 
   unsigned int downSampledX = Nx/guide->transverseDiscretization().downsamplingRatio;
+  unsigned int downSampledY = Ny/guide->verticalDiscretization().downsamplingRatio;
   unsigned int downSampledZ = Nz/guide->longitudinalDiscretization().downsamplingRatio;
 
   // Deallocate if already allocated
@@ -33,7 +34,8 @@ void Solver3D::setSimulator( ParaxialSimulation &sim )
 
   prevSolution = new arma::cx_mat(Ny,Nx);
   currentSolution = new arma::cx_mat(Ny,Nx);
-  solution = new arma::cx_cube( downSampledX, downSampledX, downSampledZ+1 );
+  unsigned int nSlices = storeSolution ? downSampledZ+1:0;
+  solution = new arma::cx_cube( downSampledY, downSampledX, nSlices );
 
   if ( downSampledX != Nx )
   {
@@ -81,23 +83,30 @@ void Solver3D::copyCurrentSolution( unsigned int step )
   assert( currentSolution->n_cols == prevSolution->n_cols );
 
   *prevSolution = *currentSolution;
+  storeSlice( *currentSolution, step );
+}
+
+void Solver3D::storeSlice( const arma::cx_mat &field, unsigned int step )
+{
+  // Only the last plane is kept when the planes are not stored
+  if ( !storeSolution || ( solution->n_slices == 0 ) ) return;
 
   if (step%guide->longitudinalDiscretization().downsamplingRatio == 0 )
   {
     unsigned int currZ = step/guide->longitudinalDiscretization().downsamplingRatio;
-    if (( currentSolution->n_rows != solution->n_rows ) || ( currentSolution->n_cols != solution->n_cols ))
+    if (( field.n_rows != solution->n_rows ) || ( field.n_cols != solution->n_cols ))
     {
       // TODO: Old implementation of downsampling, remove in future
       //filterTransverse( *currentSolution );
     }
 
-    double deltaX = static_cast<double>( currentSolution->n_rows )/static_cast<double>( solution->n_rows );
-    double deltaY = static_cast<double>( currentSolution->n_cols )/static_cast<double>( solution->n_cols );
+    double deltaX = static_cast<double>( field.n_rows )/static_cast<double>( solution->n_rows );
+    double deltaY = static_cast<double>( field.n_cols )/static_cast<double>( solution->n_cols );
 
     unsigned int maxX = deltaX*( solution->n_rows - 1 );
     unsigned int maxY = deltaY*( solution->n_cols - 1 );
-    assert( maxX < currentSolution->n_rows );
-    assert( maxY < currentSolution->n_cols );
+    assert( maxX < field.n_rows );
+    assert( maxY < field.n_cols );
 
     // Downsample the array
     if ( currZ < solution->n_slices )
@@ -109,21 +118,26 @@ void Solver3D::copyCurrentSolution( unsigned int step )
         unsigned int col = i/solution->n_rows;
         //(*solution)(row,col,currZ) = (*currentSolution)( row*deltaX, col*deltaY );
         (*solution)(row,col,currZ) = arma::sum( arma::sum(
-          currentSolution->submat( row*deltaX, col*deltaY, row*deltaX+deltaX-1, col*deltaY+deltaY-1) ))/(deltaX*deltaY);
+          field.submat( row*deltaX, col*deltaY, row*deltaX+deltaX-1, col*deltaY+deltaY-1) ))/(deltaX*deltaY);
       }
     }
     else
     {
-      static bool printWarning = true;
-      if ( printWarning )
+      if ( printOutOfBoundsWarning )
       {
         cout << "Warning! The z-index is out of bounds. Stops saving fields...\n";
-        printWarning = false;
+        printOutOfBoundsWarning = false;
       }
     }
   }
 }
 
+bool Solver3D::isStoredStep( unsigned int step ) const
+{
+  return ( step%guide->longitudinalDiscretization().downsamplingRatio == 0 ) ||
+         ( step == guide->nodeNumberLongitudinal()-1 );
+}
+
 void Solver3D::setInitialConditions( const arma::cx_mat &values )
 {
 
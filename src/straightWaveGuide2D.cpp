@@ -0,0 +1,17 @@
+#include "straightWaveGuide2D.hpp"
+
+void StraightWaveGuideFD::fillInfo( Json::Value &obj ) const
+{
+  obj["Width"] = width;
+  obj["crd"] = "cartesian";
+}
+
+bool StraightWaveGuideFD::isInsideGuide( double x, double z ) const
+{
+  return ( x > 0.0 ) && ( x < width );
+}
+
+bool StraightWaveGuideFD::materialIsZIndependent() const
+{
+  return wglength >= longitudinalDiscretization().max;
+}
@@ -0,0 +1,158 @@
+#include "thomasAlgorithm.hpp"
+#include <omp.h>
+
+using namespace std;
+typedef complex<double> cdouble;
+
+ThomasAlgorithm::~ThomasAlgorithm()
+{
+  delete [] threadWorkspaces;
+}
+
+void ThomasAlgorithm::allocateThreadWorkspaces()
+{
+  unsigned int nThreads = omp_get_max_threads();
+  if ( nWorkspaces >= nThreads ) return;
+  delete [] threadWorkspaces;
+  threadWorkspaces = new Workspace[nThreads];
+  nWorkspaces = nThreads;
+}
+
+size_t ThomasAlgorithm::scratchBytes( unsigned int N )
+{
+  return 8*Workspace::bytes<double>(N*LANES) + Workspace::bytes<cdouble>(N);
+}
+
+void ThomasAlgorithm::reserve( unsigned int N )
+{
+  allocateThreadWorkspaces();
+  for ( unsigned int i=0;i<nWorkspaces;i++ )
+  {
+    threadWorkspaces[i].reserve( scratchBytes(N) );
+  }
+}
+
+void ThomasAlgorithm::solveBatch( cdouble diag[], const cdouble subdiag[], cdouble rhs[], unsigned int N, unsigned int nSystems )
+{
+  unsigned int nGroups = nSystems/LANES;
+  allocateThreadWorkspaces();
+
+  #pragma omp parallel
+  {
+    // Interleaved copies of one group of systems, one set per thread
+    Workspace &ws = threadWorkspaces[omp_get_thread_num()];
+    ws.reserve( scratchBytes(N) );
+    unsigned int size = N*LANES;
+    double *diagRe = ws.allocate<double>(size);
+    double *diagIm = ws.allocate<double>(size);
+    double *subRe = ws.allocate<double>(size);
+    double *subIm = ws.allocate<double>(size);
+    double *rhsRe = ws.allocate<double>(size);
+    double *rhsIm = ws.allocate<double>(size);
+    double *supRe = ws.allocate<double>(size);
+    double *supIm = ws.allocate<double>(size);
+    cdouble *supdiag = ws.allocate<cdouble>(N);
+
+    #pragma omp for schedule(static)
+    for ( unsigned int g=0;g<nGroups;g++ )
+    {
+      unsigned int start = g*LANES*N;
+      for ( unsigned int l=0;l<LANES;l++ )
+      {
+        for ( unsigned int i=0;i<N;i++ )
+        {
+          unsigned int src = start+l*N+i;
+          unsigned int dest = i*LANES+l;
+          diagRe[dest] = diag[src].real();
+          diagIm[dest] = diag[src].imag();
+          subRe[dest] = subdiag[src].real();
+          subIm[dest] = subdiag[src].imag();
+          rhsRe[dest] = rhs[src].real();
+          rhsIm[dest] = rhs[src].imag();
+        }
+      }
+
+      solveInterleaved( diagRe, diagIm, subRe, subIm, rhsRe, rhsIm, N, supRe, supIm );
+
+      for ( unsigned int l=0;l<LANES;l++ )
+      {
+        for ( unsigned int i=0;i<N;i++ )
+        {
+          diag[start+l*N+i] = cdouble( diagRe[i*LANES+l], diagIm[i*LANES+l] );
+        }
+      }
+    }
+
+    // The remaining systems are solved one by one
+    #pragma omp for schedule(static)
+    for ( unsigned int n=nGroups*LANES;n<nSystems;n++ )
+    {
+      unsigned int start = n*N;
+      solve( &diag[start], &subdiag[start], &rhs[start], N, supdiag );
+    }
+  }
+}
+
+void ThomasAlgorithm::solveInterleaved( double diagRe[], double diagIm[], const double subRe[], const double subIm[],
+                                        double rhsRe[], double rhsIm[], unsigned int N, double supRe[], double supIm[] ) const
+{
+  // Forward step. The reciprocal of the pivot is computed once and used for both the superdiagonal and the right hand side
+  #pragma omp simd
+  for ( unsigned int l=0;l<LANES;l++ )
+  {
+    double norm = 1.0/( diagRe[l]*diagRe[l] + diagIm[l]*diagIm[l] );
+    double invRe = diagRe[l]*norm;
+    double invIm = -diagIm[l]*norm;
+    supRe[l] = subRe[l]*invRe - subIm[l]*invIm;
+    supIm[l] = subRe[l]*invIm + subIm[l]*invRe;
+    double re = rhsRe[l]*invRe - rhsIm[l]*invIm;
+    double im = rhsRe[l]*invIm + rhsIm[l]*invRe;
+    rhsRe[l] = re;
+    rhsIm[l] = im;
+  }
+
+  for ( unsigned int i=1;i<N;i++ )
+  {
+    #pragma omp simd
+    for ( unsigned int l=0;l<LANES;l++ )
+    {
+      unsigned int prev = (i-1)*LANES+l;
+      unsigned int cur = i*LANES+l;
+
+      // Pivot: diag[i] - subdiag[i-1]*supdiag[i-1]
+      double pivRe = diagRe[cur] - ( subRe[prev]*supRe[prev] - subIm[prev]*supIm[prev] );
+      double pivIm = diagIm[cur] - ( subRe[prev]*supIm[prev] + subIm[prev]*supRe[prev] );
+      double norm = 1.0/( pivRe*pivRe + pivIm*pivIm );
+      double invRe = pivRe*norm;
+      double invIm = -pivIm*norm;
+
+      // The last superdiagonal element is not used, so it is computed for all rows to keep the loop branch free
+      supRe[cur] = subRe[cur]*invRe - subIm[cur]*invIm;
+      supIm[cur] = subRe[cur]*invIm + subIm[cur]*invRe;
+
+      double re = rhsRe[cur] - ( subRe[prev]*rhsRe[prev] - subIm[prev]*rhsIm[prev] );
+      double im = rhsIm[cur] - ( subRe[prev]*rhsIm[prev] + subIm[prev]*rhsRe[prev] );
+      rhsRe[cur] = re*invRe - im*invIm;
+      rhsIm[cur] = re*invIm + im*invRe;
+    }
+  }
+
+  // Solve
+  #pragma omp simd
+  for ( unsigned int l=0;l<LANES;l++ )
+  {
+    diagRe[(N-1)*LANES+l] = rhsRe[(N-1)*LANES+l];
+    diagIm[(N-1)*LANES+l] = rhsIm[(N-1)*LANES+l];
+  }
+  for ( int i=N-2;i>=0;i-- )
+  {
+    #pragma omp simd
+    for ( unsigned int l=0;l<LANES;l++ )
+    {
+      unsigned int cur = i*LANES+l;
+      unsigned int next = cur+LANES;
+      diagRe[cur] = rhsRe[cur] - ( supRe[cur]*diagRe[next] - supIm[cur]*diagIm[next] );
+      diagIm[cur] = rhsIm[cur] - ( supRe[cur]*diagIm[next] + supIm[cur]*diagRe[next] );
+    }
+  }
+}
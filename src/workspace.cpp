@@ -0,0 +1,27 @@
+#include "workspace.hpp"
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+Workspace::~Workspace()
+{
+  free( data );
+}
+
+void Workspace::reserve( size_t newBytes )
+{
+  offset = 0;
+  if ( newBytes <= nBytes ) return;
+
+  free( data );
+  data = NULL;
+  nBytes = 0;
+  void *ptr = NULL;
+  if ( posix_memalign( &ptr, ALIGNMENT, newBytes ) != 0 )
+  {
+    throw( bad_alloc() );
+  }
+  data = static_cast<char*>( ptr );
+  nBytes = newBytes;
+}
@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+#include "sphereFixture.hpp"
+
+/** Damps the rows and then the columns of the field, as the absorber did before it was fused with the refraction */
+void absorberTestTwoPass( arma::cx_mat &field, unsigned int thickness, double inverseDampingLength )
+{
+  for ( unsigned int row=0;row<field.n_rows;row++ )
+  {
+    for ( unsigned int i=0;i<thickness;i++ )
+    {
+      field(row,i) *= exp( -static_cast<double>(thickness-i-1)*inverseDampingLength );
+      field(row,field.n_cols-i-1) *= exp( -static_cast<double>(thickness-i-1)*inverseDampingLength );
+    }
+  }
+
+  for ( unsigned int col=0;col<field.n_cols;col++ )
+  {
+    for ( unsigned int i=0;i<thickness;i++ )
+    {
+      field(i,col) *= exp( -static_cast<double>(thickness-i-1)*inverseDampingLength );
+      field(field.n_rows-i-1,col) *= exp( -static_cast<double>(thickness-i-1)*inverseDampingLength );
+    }
+  }
+}
+
+TEST( absorber, fusedMatchesTwoPass )
+{
+  for ( Splitting_t splitting : {Splitting_t::LIE, Splitting_t::STRANG} )
+  {
+    // One step through the fiber, such that the two pass result can be obtained from the field without absorber
+    SphereFixture fixture;
+    fixture.Nz = 1;
+    fixture.splitting = splitting;
+    FixtureFiber fiber( 0.3*fixture.radius );
+    arma::cx_cube planes;
+    arma::cx_mat twoPass, fused;
+    fixture.solveFFT3D( fiber, planes, twoPass );
+
+    fixture.absorberWidth = 0.2;
+    fixture.absorberDampingLength = 0.2;
+    fixture.solveFFT3D( fiber, planes, fused );
+
+    // Same pixel size and damping as FFTSolver3D::absorbingBC
+    double step = 2.0*fixture.halfWidth*fixture.radius/fixture.N;
+    unsigned int thickness = fixture.absorberWidth*fixture.radius/step + 1;
+    absorberTestTwoPass( twoPass, thickness, step/(fixture.absorberDampingLength*fixture.radius) );
+
+    ASSERT_EQ( fused.n_rows, twoPass.n_rows );
+    ASSERT_EQ( fused.n_cols, twoPass.n_cols );
+    EXPECT_NEAR( arma::norm( fused-twoPass, "fro" )/arma::norm( twoPass, "fro" ), 0.0, 1E-12 );
+  }
+}
@@ -1,6 +1,18 @@
 #include <gtest/gtest.h>
 
 #include "transformTest.cpp"
+#include "precisionTest.cpp"
+#include "thomasTest.cpp"
+#include "projectionTest.cpp"
+#include "referenceTest.cpp"
+#include "schedulerTest.cpp"
+#include "sceneTest.cpp"
+#include "crankNicholsonTest.cpp"
+#include "scanTest.cpp"
+#include "hankelTest.cpp"
+#include "vacuumTest.cpp"
+#include "splittingTest.cpp"
+#include "absorberTest.cpp"
 
 int main( int argc, char **argv )
 {
@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+#include "straightWaveGuide2D.hpp"
+#include "crankNicholson.hpp"
+#include "gaussianBeam.hpp"
+#include "cladding.hpp"
+#include "batchedCrankNicholson.hpp"
+
+/** Straight waveguide that reports a z-dependent material, so the coefficients are evaluated in every step */
+class PerStepStraightWaveGuide: public StraightWaveGuideFD
+{
+public:
+  virtual bool materialIsZIndependent() const override { return false; };
+};
+
+/** Propagates a Gaussian beam through a straight waveguide in nSteps steps */
+void crankNicholsonTestGuide( StraightWaveGuideFD &guide, CrankNicholson &solver, unsigned int nSteps, unsigned int downsampling=1 )
+{
+  double width = 100.0;
+  double length = 1E4;
+  Cladding cladding;
+  cladding.setRefractiveIndex( 4.9E-5, 8.9E-6 );
+  guide.setWidth( width );
+  guide.setCladding( cladding );
+  guide.setTransverseDiscretization( -width, 2.0*width, 3.0*width/256 );
+  guide.setLongitudinalDiscretization( 0.0, length, length/nSteps, downsampling );
+
+  GaussianBeam gbeam;
+  gbeam.setWaist( 0.5*width );
+  gbeam.setCenter( 0.5*width, 0.0 );
+  gbeam.setWavelength( 0.157 );
+
+  solver.disableLongitudinalFilter();
+  guide.setSolver( solver );
+  guide.setBoundaryConditions( gbeam );
+  guide.solve();
+}
+
+TEST( crankNicholson, cachedPlaneMatchesPerStepEvaluation )
+{
+  StraightWaveGuideFD cachedGuide;
+  PerStepStraightWaveGuide perStepGuide;
+  EXPECT_TRUE( cachedGuide.materialIsZIndependent() );
+
+  CrankNicholson cachedSolver;
+  CrankNicholson perStepSolver;
+  crankNicholsonTestGuide( cachedGuide, cachedSolver, 128 );
+  crankNicholsonTestGuide( perStepGuide, perStepSolver, 128 );
+  const arma::cx_vec &cached = cachedSolver.getLastSolution();
+  const arma::cx_vec &perStep = perStepSolver.getLastSolution();
+  ASSERT_EQ( cached.n_elem, perStep.n_elem );
+  EXPECT_NEAR( arma::norm( cached-perStep ), 0.0, 1E-12*arma::norm( perStep ) );
+}
+
+TEST( crankNicholson, adaptiveStepsMatchFineFixedSteps )
+{
+  const unsigned int nSteps = 256;
+  const unsigned int landingRatio = 16;
+  const unsigned int refinement = 4;
+  const double tolerance = 1E-4;
+
+  StraightWaveGuideFD adaptiveGuide;
+  CrankNicholson adaptiveSolver;
+  adaptiveSolver.setAdaptiveStepping( tolerance, 1.0 );
+  crankNicholsonTestGuide( adaptiveGuide, adaptiveSolver, nSteps, landingRatio );
+
+  StraightWaveGuideFD fineGuide;
+  CrankNicholson fineSolver;
+  crankNicholsonTestGuide( fineGuide, fineSolver, nSteps*refinement );
+
+  // The solution is stored on all grid planes, but the substeps are longer than the grid step
+  const arma::cx_mat &adaptive = adaptiveSolver.getSolution();
+  const arma::cx_mat &fine = fineSolver.getSolution();
+  ASSERT_EQ( adaptive.n_cols, nSteps+1 );
+  ASSERT_EQ( fine.n_cols, nSteps*refinement+1 );
+  unsigned int nSubsteps = adaptiveSolver.getNumberOfAcceptedSubsteps();
+  EXPECT_LT( nSubsteps, nSteps );
+
+  // The tolerance bounds the local error of each substep, so the global error on the landing planes is bounded by their sum
+  for ( unsigned int iz=landingRatio;iz<=nSteps;iz+=landingRatio )
+  {
+    arma::cx_vec reference = fine.col( iz*refinement );
+    double relError = arma::norm( adaptive.col(iz)-reference )/arma::norm( reference );
+    EXPECT_LT( relError, nSubsteps*tolerance );
+  }
+}
+
+TEST( crankNicholson, batchMatchesSeparateRuns )
+{
+  const unsigned int M = 3;
+  double widths[M] = {60.0, 100.0, 140.0};
+  double length = 1E4;
+  Cladding cladding;
+  cladding.setRefractiveIndex( 4.9E-5, 8.9E-6 );
+  GaussianBeam gbeam;
+  gbeam.setWaist( 50.0 );
+  gbeam.setCenter( 50.0, 0.0 );
+  gbeam.setWavelength( 0.157 );
+
+  StraightWaveGuideFD guides[M];
+  CrankNicholson solvers[M];
+  BatchedCrankNicholson batch;
+  for ( unsigned int m=0;m<M;m++ )
+  {
+    guides[m].setWidth( widths[m] );
+    guides[m].setCladding( cladding );
+    guides[m].setTransverseDiscretization( -100.0, 200.0, 300.0/256 );
+    guides[m].setLongitudinalDiscretization( 0.0, length, length/128 );
+    guides[m].setSolver( solvers[m] );
+    guides[m].setBoundaryConditions( gbeam );
+    batch.addSimulation( guides[m], widths[m] );
+  }
+  batch.solve();
+
+  for ( unsigned int m=0;m<M;m++ )
+  {
+    guides[m].solve();
+    const arma::cx_vec &separate = solvers[m].getLastSolution();
+    const arma::cx_mat &batched = batch.getSolution( m );
+    ASSERT_EQ( batched.n_rows, separate.n_elem );
+    arma::cx_vec batchedExit = batched.col( batched.n_cols-1 );
+    EXPECT_NEAR( arma::norm( batchedExit-separate ), 0.0, 1E-10*arma::norm( separate ) );
+  }
+}
@@ -0,0 +1,38 @@
+#include <gtest/gtest.h>
+#include "hankelSolver3D.hpp"
+#include "gaussianBeam.hpp"
+#include "paraxialSimulation.hpp"
+
+TEST( hankel, vacuumMatchesAnalyticGaussianBeam )
+{
+  double halfWidth = 20.0;
+  double dx = 2.0*halfWidth/256;
+  double length = 200.0;
+
+  // The Rayleigh range is 126, so the beam expands by almost a factor two
+  GaussianBeam gbeam;
+  gbeam.setDim( ParaxialSource::Dim_t::THREE_D );
+  gbeam.setWaist( 2.0 );
+  gbeam.setWavelength( 0.1 );
+
+  ParaxialSimulation sim("hankelTest");
+  sim.setTransverseDiscretization( -halfWidth, halfWidth, dx );
+  sim.setVerticalDiscretization( -halfWidth, halfWidth, dx );
+  sim.setLongitudinalDiscretization( 0.0, length, length/20 );
+  HankelSolver3D solver;
+  sim.setSolver( solver );
+  sim.setBoundaryConditions( gbeam );
+  sim.solve();
+
+  const arma::vec &r = solver.getRadialNodes();
+  const arma::cx_vec &field = solver.getRadialField();
+  arma::cx_vec analytic( r.n_elem );
+  for ( unsigned int n=0;n<r.n_elem;n++ )
+  {
+    analytic[n] = gbeam.get( r[n], 0.0, length );
+  }
+
+  // The diffraction step is exact in vacuum, the error comes from interpolating the initial field onto the radial nodes
+  EXPECT_NEAR( arma::norm( field-analytic ), 0.0, 5E-3*arma::norm( analytic ) );
+  EXPECT_NEAR( std::abs( field[0]-analytic[0] ), 0.0, 5E-3*std::abs( analytic[0] ) );
+}
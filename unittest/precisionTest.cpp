@@ -0,0 +1,36 @@
+#include <gtest/gtest.h>
+#include "sphereFixture.hpp"
+
+/** Returns the far field of a small sphere computed with the given solver and precision */
+void precisionTestFarField( GenericScattering::SolverType_t solverType, Precision_t precision, arma::mat &farField )
+{
+  SphereFixture fixture;
+  fixture.N = 128;
+  fixture.Nz = 32;
+  fixture.FFTPadLength = 256;
+  fixture.solver = solverType;
+  fixture.precision = precision;
+  fixture.farField( 1, farField );
+}
+
+TEST( precision, fftSolverSingleMatchesDouble )
+{
+  arma::mat farDouble;
+  arma::mat farSingle;
+  precisionTestFarField( GenericScattering::SolverType_t::FFT, Precision_t::DOUBLE, farDouble );
+  precisionTestFarField( GenericScattering::SolverType_t::FFT, Precision_t::SINGLE, farSingle );
+  ASSERT_EQ( farDouble.n_rows, farSingle.n_rows );
+  ASSERT_EQ( farDouble.n_cols, farSingle.n_cols );
+  EXPECT_NEAR( arma::norm( farSingle-farDouble, "fro" )/arma::norm( farDouble, "fro" ), 0.0, 1E-3 );
+}
+
+TEST( precision, projectionSolverSingleMatchesDouble )
+{
+  arma::mat farDouble;
+  arma::mat farSingle;
+  precisionTestFarField( GenericScattering::SolverType_t::PROJ, Precision_t::DOUBLE, farDouble );
+  precisionTestFarField( GenericScattering::SolverType_t::PROJ, Precision_t::SINGLE, farSingle );
+  ASSERT_EQ( farDouble.n_rows, farSingle.n_rows );
+  ASSERT_EQ( farDouble.n_cols, farSingle.n_cols );
+  EXPECT_NEAR( arma::norm( farSingle-farDouble, "fro" )/arma::norm( farDouble, "fro" ), 0.0, 1E-3 );
+}
@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+#include "materialFunction.hpp"
+#include "geometry.hpp"
+#include <cmath>
+
+TEST( projection, sphereChordLength )
+{
+  geom::Sphere sphere( 2.0 );
+  sphere.translate( 0.5, -0.5, 1.0 );
+  geom::Part part("sphere");
+  part.add( sphere );
+  part.delta = 1E-5;
+  part.beta = 1E-7;
+  geom::Module module("sphere");
+  module.add( part );
+  CSGMaterial material;
+  material.addModule( module );
+
+  // The line at distance 1 from the center crosses a chord of length 2*sqrt(3)
+  double deltaInt, betaInt;
+  material.getProjectedXrayMatProp( 1.5, -0.5, -10.0, 10.0, deltaInt, betaInt );
+  EXPECT_NEAR( deltaInt, 2E-5*sqrt(3.0), 1E-15 );
+  EXPECT_NEAR( betaInt, 2E-7*sqrt(3.0), 1E-17 );
+
+  // Only the part of the chord beyond z = 1 is included
+  material.getProjectedXrayMatProp( 1.5, -0.5, 1.0, 10.0, deltaInt, betaInt );
+  EXPECT_NEAR( deltaInt, 1E-5*sqrt(3.0), 1E-15 );
+}
+
+TEST( projection, differenceMatchesSlices )
+{
+  geom::Box box( 4.0, 4.0, 4.0 );
+  box.rotate( 30.0, geom::Axis_t::X );
+  geom::Cylinder hole( 1.0, 6.0 );
+  geom::Part part("boxWithHole");
+  part.add( box );
+  part.difference( hole );
+  part.delta = 1.0;
+  part.beta = 0.1;
+  geom::Module module("boxWithHole");
+  module.add( part );
+  CSGMaterial material;
+  material.addModule( module );
+
+  unsigned int N = 100000;
+  double zmin = -5.0;
+  double zmax = 5.0;
+  double dz = (zmax-zmin)/N;
+  for ( double x=-2.5;x<2.5;x+=0.7 )
+  {
+    double deltaInt, betaInt;
+    material.getProjectedXrayMatProp( x, 0.3, zmin, zmax, deltaInt, betaInt );
+
+    double deltaSum = 0.0;
+    for ( unsigned int i=0;i<N;i++ )
+    {
+      double delta, beta;
+      material.getXrayMatProp( x, 0.3, zmin+(i+0.5)*dz, delta, beta );
+      deltaSum += delta*dz;
+    }
+    EXPECT_NEAR( deltaInt, deltaSum, 4.0*dz );
+  }
+}
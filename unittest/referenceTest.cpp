@@ -0,0 +1,47 @@
+#include <gtest/gtest.h>
+#include "sphereFixture.hpp"
+
+TEST( reference, cachedMatchesPropagated )
+{
+  SphereFixture fixture;
+  arma::mat farPropagated;
+  arma::mat farCached;
+  fixture.farField( 1, farPropagated );
+
+  // The second solve reuses the reference from the first
+  fixture.reference = GenericScattering::Reference_t::CACHED;
+  fixture.farField( 2, farCached );
+  EXPECT_NEAR( arma::norm( farCached-farPropagated, "fro" ), 0.0, 1E-12*arma::norm( farPropagated, "fro" ) );
+}
+
+/** Far field with the reference obtained by propagation and analytically, for a waist comparable to the sphere */
+void referenceTestAnalytic( GenericScattering::SolverType_t solver, arma::mat &farPropagated, arma::mat &farAnalytic )
+{
+  SphereFixture fixture;
+  fixture.N = 128;
+  fixture.FFTPadLength = 256;
+  fixture.halfWidth = 3.0;
+  fixture.waist = 1.0;
+  fixture.solver = solver;
+  fixture.farField( 1, farPropagated );
+  fixture.reference = GenericScattering::Reference_t::ANALYTIC;
+  fixture.farField( 1, farAnalytic );
+}
+
+TEST( reference, analyticMatchesPropagatedFFT )
+{
+  arma::mat farPropagated;
+  arma::mat farAnalytic;
+  referenceTestAnalytic( GenericScattering::SolverType_t::FFT, farPropagated, farAnalytic );
+
+  // The wavefront curvature across the beam gives an error of about 7E-2 if it is left out in y
+  EXPECT_NEAR( arma::norm( farAnalytic-farPropagated, "fro" ), 0.0, 1E-3*arma::norm( farPropagated, "fro" ) );
+}
+
+TEST( reference, analyticMatchesPropagatedProjection )
+{
+  arma::mat farPropagated;
+  arma::mat farAnalytic;
+  referenceTestAnalytic( GenericScattering::SolverType_t::PROJ, farPropagated, farAnalytic );
+  EXPECT_NEAR( arma::norm( farAnalytic-farPropagated, "fro" ), 0.0, 1E-8*arma::norm( farPropagated, "fro" ) );
+}
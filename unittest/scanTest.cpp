@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include <H5Cpp.h>
+#include <cstdio>
+#include "sphereFixture.hpp"
+
+/** Reads the results of one scan point from a (scan point, ...) dataset */
+void scanTestReadPoint( H5::DataSet &dset, unsigned int k, arma::mat &res )
+{
+  hsize_t dims[3];
+  dset.getSpace().getSimpleExtentDims( dims );
+  res.set_size( dims[2], dims[1] );
+  hsize_t count[3] = {1, dims[1], dims[2]};
+  hsize_t offset[3] = {k, 0, 0};
+  H5::DataSpace fileSpace = dset.getSpace();
+  fileSpace.selectHyperslab( H5S_SELECT_SET, count, offset );
+  H5::DataSpace memSpace( 3, count );
+  dset.read( res.memptr(), H5::PredType::NATIVE_DOUBLE, memSpace, fileSpace );
+}
+
+TEST( scan, pointsMatchStandaloneSolves )
+{
+  SphereFixture fixture;
+  geom::Box box( 60.0, 30.0, 40.0 );
+  geom::Part part("scanBox");
+  part.add( box );
+  part.delta = 8.9E-6;
+  part.beta = 7E-7;
+  geom::Module sample("scanSample");
+  sample.add( part );
+  CSGMaterial material;
+  material.addModule( sample );
+
+  // The third point repeats the second, which reuses the previous solution
+  std::vector<ScanPoint> points( 3 );
+  points[1].angleDeg = 30.0;
+  points[1].axis = geom::Axis_t::Z;
+  points[1].x = 10.0;
+  points[2] = points[1];
+
+  std::vector<arma::mat> initialPose;
+  sample.getTransformations( initialPose );
+
+  const char* fname = "scanTest.h5";
+  GenericScattering scanSim("scanTest");
+  fixture.setup( material, scanSim );
+  scanSim.scan( sample, points, fname );
+
+  // The pose of the sample is restored
+  std::vector<arma::mat> finalPose;
+  sample.getTransformations( finalPose );
+  ASSERT_EQ( finalPose.size(), initialPose.size() );
+  for ( unsigned int i=0;i<finalPose.size();i++ )
+  {
+    EXPECT_TRUE( arma::approx_equal( finalPose[i], initialPose[i], "absdiff", 1E-14 ) );
+  }
+
+  H5::H5File file( fname, H5F_ACC_RDONLY );
+  H5::DataSet farSet = file.openDataSet( "/data/farField" );
+  hsize_t dims[3];
+  ASSERT_EQ( farSet.getSpace().getSimpleExtentNdims(), 3 );
+  farSet.getSpace().getSimpleExtentDims( dims );
+  EXPECT_EQ( dims[0], points.size() );
+
+  hsize_t poseDims[2];
+  file.openDataSet( "/data/scanAngle" ).getSpace().getSimpleExtentDims( poseDims );
+  EXPECT_EQ( poseDims[0], points.size() );
+
+  for ( unsigned int k=0;k<points.size();k++ )
+  {
+    sample.setTransformations( initialPose );
+    sample.rotate( points[k].angleDeg, points[k].axis );
+    sample.translate( points[k].x, points[k].y, points[k].z );
+    GenericScattering standalone("scanStandalone");
+    fixture.setup( material, standalone );
+    standalone.solve();
+    arma::mat farStandalone;
+    standalone.getFarField( farStandalone );
+
+    arma::mat farScan;
+    scanTestReadPoint( farSet, k, farScan );
+    ASSERT_EQ( farScan.n_rows, farStandalone.n_rows );
+    ASSERT_EQ( farScan.n_cols, farStandalone.n_cols );
+    EXPECT_NEAR( arma::norm( farScan-farStandalone, "fro" ), 0.0, 1E-10*arma::norm( farStandalone, "fro" ) );
+  }
+  sample.setTransformations( initialPose );
+  file.close();
+  std::remove( fname );
+}
@@ -0,0 +1,37 @@
+#include <gtest/gtest.h>
+#include <json/reader.h>
+#include <sstream>
+#include "sceneRunner.hpp"
+
+TEST( scene, buildsMaterialFromJSON )
+{
+  std::stringstream json;
+  json << "{\"domain\": {\"dx\": 1.0},"
+       << " \"material\": {\"modules\": [{\"parts\": [{\"delta\": 1E-5, \"beta\": 1E-6, \"shapes\": ["
+       << "   {\"type\": \"sphere\", \"radius\": 10.0},"
+       << "   {\"type\": \"box\", \"Lx\": 4.0, \"Ly\": 4.0, \"Lz\": 4.0, \"operation\": \"difference\"}]}],"
+       << "   \"transforms\": [{\"type\": \"translate\", \"x\": 5.0}]}]}}";
+  Json::CharReaderBuilder builder;
+  Json::Value scene;
+  std::string errors;
+  ASSERT_TRUE( Json::parseFromStream( builder, json, &scene, &errors ) );
+
+  SceneRunner runner;
+  runner.build( scene );
+  double delta = 0.0;
+  double beta = 0.0;
+
+  // Inside the sphere, but outside the box that is removed
+  runner.getSimulation().getXrayMatProp( 11.0, 0.0, 0.0, delta, beta );
+  EXPECT_DOUBLE_EQ( delta, 1E-5 );
+  EXPECT_DOUBLE_EQ( beta, 1E-6 );
+
+  // Inside the removed box
+  runner.getSimulation().getXrayMatProp( 5.0, 0.0, 0.0, delta, beta );
+  EXPECT_DOUBLE_EQ( delta, 0.0 );
+
+  // Outside the translated sphere
+  runner.getSimulation().getXrayMatProp( -6.0, 0.0, 0.0, delta, beta );
+  EXPECT_DOUBLE_EQ( delta, 0.0 );
+  EXPECT_EQ( runner.getOutputFile(), "scene.h5" );
+}
@@ -0,0 +1,42 @@
+#include <gtest/gtest.h>
+#include "sphereFixture.hpp"
+#include "simulationScheduler.hpp"
+
+TEST( scheduler, concurrentMatchesSerial )
+{
+  const unsigned int nJobs = 3;
+  double radii[nJobs] = {30.0, 40.0, 50.0};
+  std::vector<FixtureSphere*> spheres;
+  std::vector<GenericScattering*> simulations;
+  SimulationScheduler scheduler;
+  scheduler.setConcurrentJobs( 2 );
+  scheduler.setThreadsPerJob( 1 );
+  for ( unsigned int i=0;i<nJobs;i++ )
+  {
+    SphereFixture fixture;
+    fixture.radius = radii[i];
+    spheres.push_back( new FixtureSphere( radii[i] ) );
+    simulations.push_back( new GenericScattering("schedulerTest") );
+    fixture.setup( *spheres[i], *simulations[i] );
+    scheduler.add( *simulations[i] );
+  }
+
+  EXPECT_EQ( scheduler.run(), 0 );
+  for ( unsigned int i=0;i<nJobs;i++ )
+  {
+    EXPECT_TRUE( scheduler.succeeded(i) );
+    arma::mat farConcurrent;
+    simulations[i]->getFarField( farConcurrent );
+
+    arma::mat farSerial;
+    simulations[i]->solve();
+    simulations[i]->getFarField( farSerial );
+    EXPECT_NEAR( arma::norm( farConcurrent-farSerial, "fro" ), 0.0, 1E-12*arma::norm( farSerial, "fro" ) );
+  }
+
+  for ( unsigned int i=0;i<nJobs;i++ )
+  {
+    delete simulations[i];
+    delete spheres[i];
+  }
+}
@@ -0,0 +1,194 @@
+#ifndef SPHERE_FIXTURE_H
+#define SPHERE_FIXTURE_H
+#include "genericScattering.hpp"
+#include "materialFunction.hpp"
+#include "paraxialSimulation.hpp"
+#include "fftSolver2D.hpp"
+#include "gaussianBeam.hpp"
+
+/** Homogeneous sphere centered at the origin */
+class FixtureSphere: public MaterialFunction
+{
+public:
+  FixtureSphere( double rad ): radius(rad){};
+  void getXrayMatProp( double x, double y, double z, double &delta, double &beta ) const override
+  {
+    if ( x*x + y*y + z*z < radius*radius )
+    {
+      delta = 8.9E-6;
+      beta = 7E-7;
+      return;
+    }
+    delta = 0.0;
+    beta = 0.0;
+  }
+private:
+  double radius{0.0};
+};
+
+/** Fiber along the z-axis with a Gaussian profile. Without sharp borders the splitting error dominates */
+class FixtureFiber: public MaterialFunction
+{
+public:
+  FixtureFiber( double rad ): radius(rad){};
+  void getXrayMatProp( double x, double y, double z, double &delta, double &beta ) const override
+  {
+    double profile = exp( -(x*x+y*y)/(radius*radius) );
+    delta = 8.9E-6*profile;
+    beta = 7E-7*profile;
+  }
+private:
+  double radius{0.0};
+};
+
+/** Parameters of the small sphere scattering setup shared by the tests. Lengths are in units of the radius */
+struct SphereFixture
+{
+  double radius{50.0};
+  unsigned int N{64};
+  unsigned int Nz{16};
+  unsigned int FFTPadLength{128};
+  double halfWidth{1.5};
+  double zHalfLength{1.05};
+  unsigned int downSampleZ{0}; // 0 stores only the first and the last plane
+  double waist{400.0};
+  double wavelength{0.1569};
+  GenericScattering::SolverType_t solver{GenericScattering::SolverType_t::FFT};
+  Precision_t precision{Precision_t::DOUBLE};
+  Splitting_t splitting{Splitting_t::LIE};
+  bool vacuumSkipping{true};
+  double absorberWidth{0.0}; // Only used by solveFFT3D. 0 disables the absorber
+  double absorberDampingLength{0.1};
+  GenericScattering::Reference_t reference{GenericScattering::Reference_t::PROPAGATE};
+
+  /** Sets up the simulation. The material has to outlive the simulation */
+  void setup( const MaterialFunction &material, GenericScattering &simulation ) const
+  {
+    double r = radius;
+    simulation.setBeamWaist( waist*r );
+    simulation.wavelength = wavelength;
+    simulation.setMaxScatteringAngle( 0.05 );
+    simulation.xmin = -halfWidth*r;
+    simulation.xmax = halfWidth*r;
+    simulation.ymin = -halfWidth*r;
+    simulation.ymax = halfWidth*r;
+    simulation.zmin = -zHalfLength*r;
+    simulation.zmax = zHalfLength*r;
+    simulation.dx = 2.0*halfWidth*r/N;
+    simulation.dy = 2.0*halfWidth*r/N;
+    simulation.dz = 2.0*zHalfLength*r/Nz;
+    simulation.downSampleX = 1;
+    simulation.downSampleY = 1;
+    simulation.downSampleZ = downSampleZ > 0 ? downSampleZ:Nz;
+    simulation.exportNx = N;
+    simulation.exportNy = N;
+    simulation.FFTPadLength = FFTPadLength;
+    simulation.supressMessages = true;
+    simulation.propagator = solver;
+    simulation.fftPrecision = precision;
+    simulation.fftSplitting = splitting;
+    simulation.fftVacuumSkipping = vacuumSkipping;
+    simulation.referenceMode = reference;
+    simulation.setMaterial( material );
+  };
+
+  /** Sets up a 2D simulation in the plane y = 0 of the material. The solver and the source are set afterwards */
+  void setup2D( const MaterialFunction &material, ParaxialSimulation &simulation ) const
+  {
+    double r = radius;
+    unsigned int ratio = downSampleZ > 0 ? downSampleZ:Nz;
+    simulation.setTransverseDiscretization( -halfWidth*r, halfWidth*r, 2.0*halfWidth*r/N );
+    simulation.setLongitudinalDiscretization( -zHalfLength*r, zHalfLength*r, 2.0*zHalfLength*r/Nz, ratio );
+    simulation.setWaveLength( wavelength );
+    simulation.material = &material;
+  };
+
+  /** Solves the scattering nSolves times and returns the far field */
+  void farField( unsigned int nSolves, arma::mat &farf ) const
+  {
+    FixtureSphere sphere( radius );
+    GenericScattering simulation("sphereFixture");
+    setup( sphere, simulation );
+    for ( unsigned int i=0;i<nSolves;i++ )
+    {
+      simulation.solve();
+    }
+    simulation.getFarField( farf );
+  };
+
+  /** Solves the scattering once and returns the stored planes and the far field */
+  void solve3D( arma::cx_cube &planes, arma::mat &farf ) const
+  {
+    FixtureSphere sphere( radius );
+    GenericScattering simulation("sphereFixture");
+    setup( sphere, simulation );
+    simulation.solve();
+    planes = simulation.getSolver().getSolution3D();
+    simulation.getFarField( farf );
+  };
+
+  /** Solves the 2D problem in the plane y = 0 with the FFT solver and returns the stored planes and the exit field */
+  void solve2D( const MaterialFunction &material, arma::cx_mat &planes, arma::cx_vec &exitField ) const
+  {
+    ParaxialSimulation simulation("sphereFixture2D");
+    setup2D( material, simulation );
+    FFTSolver2D solver;
+    solver.setSplitting( splitting );
+    solver.setVacuumSkipping( vacuumSkipping );
+    solver.setPrecision( precision );
+    simulation.setSolver( solver );
+
+    GaussianBeam gbeam;
+    gbeam.setWaist( waist*radius );
+    gbeam.setWavelength( wavelength );
+    simulation.setBoundaryConditions( gbeam );
+    simulation.solve();
+    planes = solver.getSolution();
+    exitField = solver.getLastSolution();
+  };
+
+  /** Solves the 2D problem for the sphere and returns the stored planes and the far field */
+  void solve2D( arma::cx_mat &planes, arma::vec &farf ) const
+  {
+    FixtureSphere sphere( radius );
+    arma::cx_vec exitField;
+    solve2D( sphere, planes, exitField );
+    farf = arma::abs( arma::fft( exitField ) );
+  };
+
+  /**
+  * Solves the 3D problem directly with the FFT solver, without the reference and the post processing of
+  * GenericScattering, and returns the stored planes and the exit field
+  */
+  void solveFFT3D( const MaterialFunction &material, arma::cx_cube &planes, arma::cx_mat &exitField ) const
+  {
+    double r = radius;
+    ParaxialSimulation simulation("sphereFixture3D");
+    simulation.setTransverseDiscretization( -halfWidth*r, halfWidth*r, 2.0*halfWidth*r/N );
+    simulation.setVerticalDiscretization( -halfWidth*r, halfWidth*r, 2.0*halfWidth*r/N );
+    simulation.setLongitudinalDiscretization( -zHalfLength*r, zHalfLength*r, 2.0*zHalfLength*r/Nz,
+                                              downSampleZ > 0 ? downSampleZ:Nz );
+    simulation.setWaveLength( wavelength );
+    simulation.material = &material;
+
+    FFTSolver3D solver;
+    solver.setSplitting( splitting );
+    solver.setVacuumSkipping( vacuumSkipping );
+    solver.setPrecision( precision );
+    simulation.setSolver( solver );
+    if ( absorberWidth > 0.0 )
+    {
+      solver.absorbingBC( absorberWidth*r, absorberDampingLength*r );
+    }
+
+    GaussianBeam gbeam;
+    gbeam.setDim( ParaxialSource::Dim_t::THREE_D );
+    gbeam.setWaist( waist*r );
+    gbeam.setWavelength( wavelength );
+    simulation.setBoundaryConditions( gbeam );
+    simulation.solve();
+    planes = solver.getSolution3D();
+    exitField = solver.getLastSolution3D();
+  };
+};
+#endif
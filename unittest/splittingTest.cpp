@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+#include "sphereFixture.hpp"
+
+/** Sphere fixture where the last step is not a multiple of the downsampling ratio */
+SphereFixture splittingTestFixture()
+{
+  SphereFixture fixture;
+  fixture.zHalfLength = 1.5;
+  fixture.Nz = 50;
+  fixture.splitting = Splitting_t::STRANG;
+  return fixture;
+}
+
+/** Compares the planes stored with the given downsampling ratio to the planes stored in every step */
+void splittingTestCompareStoredPlanes( const arma::cx_cube &planesEvery, const arma::cx_cube &planesDown, unsigned int ratio )
+{
+  ASSERT_GT( planesDown.n_slices, 1 );
+  ASSERT_LT( (planesDown.n_slices-1)*ratio, planesEvery.n_slices );
+  for ( unsigned int i=0;i<planesDown.n_slices;i++ )
+  {
+    const arma::cx_mat &ref = planesEvery.slice(i*ratio);
+    EXPECT_NEAR( arma::norm( planesDown.slice(i)-ref, "fro" )/arma::norm( ref, "fro" ), 0.0, 1E-10 );
+  }
+}
+
+/** Relative error of the exit field at a coarse step compared to a fine step reference */
+double splittingTestError3D( Splitting_t splitting )
+{
+  SphereFixture fixture;
+  fixture.zHalfLength = 1.5;
+  FixtureFiber fiber( 0.3*fixture.radius );
+  arma::cx_cube planes;
+  arma::cx_mat reference, exitField;
+  fixture.splitting = Splitting_t::STRANG;
+  fixture.Nz = 256;
+  fixture.solveFFT3D( fiber, planes, reference );
+  fixture.splitting = splitting;
+  fixture.Nz = 16;
+  fixture.solveFFT3D( fiber, planes, exitField );
+  return arma::norm( exitField-reference, "fro" )/arma::norm( reference, "fro" );
+}
+
+/** Relative error of the exit field at a coarse step compared to a fine step reference */
+double splittingTestError2D( Splitting_t splitting )
+{
+  SphereFixture fixture;
+  fixture.zHalfLength = 1.5;
+  FixtureFiber fiber( 0.3*fixture.radius );
+  arma::cx_mat planes;
+  arma::cx_vec reference, exitField;
+  fixture.splitting = Splitting_t::STRANG;
+  fixture.Nz = 256;
+  fixture.solve2D( fiber, planes, reference );
+  fixture.splitting = splitting;
+  fixture.Nz = 16;
+  fixture.solve2D( fiber, planes, exitField );
+  return arma::norm( exitField-reference )/arma::norm( reference );
+}
+
+TEST( splitting, fftSolver3DStrangCompletesStoredPlanes )
+{
+  SphereFixture fixture = splittingTestFixture();
+  FixtureSphere sphere( fixture.radius );
+  arma::cx_cube planesEvery, planesDown;
+  arma::cx_mat exitEvery, exitDown;
+  fixture.downSampleZ = 1;
+  fixture.solveFFT3D( sphere, planesEvery, exitEvery );
+  fixture.downSampleZ = 4;
+  fixture.solveFFT3D( sphere, planesDown, exitDown );
+
+  splittingTestCompareStoredPlanes( planesEvery, planesDown, 4 );
+
+  // The last plane is completed even though it is not a downsampled plane
+  EXPECT_NEAR( arma::norm( exitDown-exitEvery, "fro" )/arma::norm( exitEvery, "fro" ), 0.0, 1E-10 );
+}
+
+TEST( splitting, fftSolver3DStrangWithAbsorber )
+{
+  SphereFixture fixture = splittingTestFixture();
+  FixtureSphere sphere( fixture.radius );
+  arma::cx_cube planesEvery, planesDown;
+  arma::cx_mat exitEvery, exitDown, exitNoAbsorber;
+  fixture.downSampleZ = 4;
+  fixture.solveFFT3D( sphere, planesDown, exitNoAbsorber );
+
+  fixture.absorberWidth = 0.2;
+  fixture.absorberDampingLength = 0.2;
+  fixture.solveFFT3D( sphere, planesDown, exitDown );
+  fixture.downSampleZ = 1;
+  fixture.solveFFT3D( sphere, planesEvery, exitEvery );
+
+  splittingTestCompareStoredPlanes( planesEvery, planesDown, 4 );
+  EXPECT_NEAR( arma::norm( exitDown-exitEvery, "fro" )/arma::norm( exitEvery, "fro" ), 0.0, 1E-10 );
+
+  // The absorber is applied in every step, also in the vacuum in front of and behind the sphere
+  EXPECT_LT( arma::norm( exitDown, "fro" ), 0.95*arma::norm( exitNoAbsorber, "fro" ) );
+}
+
+TEST( splitting, fftSolver2DStrangCompletesStoredPlanes )
+{
+  SphereFixture fixture = splittingTestFixture();
+  FixtureSphere sphere( fixture.radius );
+  arma::cx_mat planesEvery, planesDown;
+  arma::cx_vec exitEvery, exitDown;
+  fixture.downSampleZ = 1;
+  fixture.solve2D( sphere, planesEvery, exitEvery );
+  fixture.downSampleZ = 4;
+  fixture.solve2D( sphere, planesDown, exitDown );
+
+  // Without downsampling every plane is kept, and the last one is the exit field
+  ASSERT_EQ( planesEvery.n_cols, fixture.Nz+1 );
+  EXPECT_NEAR( arma::norm( planesEvery.col(fixture.Nz)-exitEvery )/arma::norm( exitEvery ), 0.0, 1E-10 );
+  EXPECT_NEAR( arma::norm( exitDown-exitEvery )/arma::norm( exitEvery ), 0.0, 1E-10 );
+}
+
+TEST( splitting, fftSolver3DStrangIsMoreAccurateThanLie )
+{
+  double errorLie = splittingTestError3D( Splitting_t::LIE );
+  double errorStrang = splittingTestError3D( Splitting_t::STRANG );
+  EXPECT_LT( errorStrang, 0.1*errorLie );
+}
+
+TEST( splitting, fftSolver2DStrangIsMoreAccurateThanLie )
+{
+  double errorLie = splittingTestError2D( Splitting_t::LIE );
+  double errorStrang = splittingTestError2D( Splitting_t::STRANG );
+  EXPECT_LT( errorStrang, 0.1*errorLie );
+}
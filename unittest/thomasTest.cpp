@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+#include "thomasAlgorithm.hpp"
+#include <omp.h>
+#include <complex>
+#include <vector>
+
+TEST( thomas, batchMatchesSingleSystems )
+{
+  typedef std::complex<double> cdouble;
+  unsigned int N = 17;
+  unsigned int nSystems = 2*ThomasAlgorithm::LANES+3; // Both interleaved groups and single systems
+  std::vector<cdouble> diag(N*nSystems), subdiag(N*nSystems), rhs(N*nSystems);
+  for ( unsigned int i=0;i<N*nSystems;i++ )
+  {
+    diag[i] = cdouble( 4.0+0.1*(i%7), 0.5 );
+    subdiag[i] = cdouble( -1.0, 0.2*(i%3) );
+    rhs[i] = cdouble( 1.0*(i%5), -0.3*(i%4) );
+  }
+
+  std::vector<cdouble> batchDiag(diag), batchRhs(rhs);
+  ThomasAlgorithm solver;
+  solver.solveBatch( &batchDiag[0], &subdiag[0], &batchRhs[0], N, nSystems );
+
+  for ( unsigned int n=0;n<nSystems;n++ )
+  {
+    solver.solve( &diag[n*N], &subdiag[n*N], &rhs[n*N], N );
+    for ( unsigned int i=0;i<N;i++ )
+    {
+      EXPECT_NEAR( abs( batchDiag[n*N+i]-diag[n*N+i] ), 0.0, 1E-12 );
+    }
+  }
+}
+
+TEST( thomas, partitionedMatchesSerial )
+{
+  typedef std::complex<double> cdouble;
+  unsigned int N = 4*ThomasAlgorithm::MIN_NODES_PER_PARTITION+5;
+  std::vector<cdouble> diag(N), subdiag(N-1), rhs(N);
+  for ( unsigned int i=0;i<N;i++ )
+  {
+    diag[i] = cdouble( 2.0+0.1*(i%7), 0.5 );
+    rhs[i] = cdouble( 1.0*(i%5), -0.3*(i%4) );
+    if ( i < N-1 ) subdiag[i] = cdouble( -1.0, 0.2*(i%3) );
+  }
+
+  // The number of partitions follows the number of threads, so four are used regardless of the machine
+  int prevThreads = omp_get_max_threads();
+  omp_set_num_threads( 4 );
+  std::vector<cdouble> partDiag(diag), partRhs(rhs);
+  ThomasAlgorithm solver;
+  solver.solvePartitioned( &partDiag[0], &subdiag[0], &partRhs[0], N );
+  omp_set_num_threads( prevThreads );
+  solver.solve( &diag[0], &subdiag[0], &rhs[0], N );
+  for ( unsigned int i=0;i<N;i++ )
+  {
+    EXPECT_NEAR( abs( partDiag[i]-diag[i] ), 0.0, 1E-12 );
+  }
+}
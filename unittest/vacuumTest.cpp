@@ -0,0 +1,59 @@
+#include <gtest/gtest.h>
+#include "sphereFixture.hpp"
+
+/** Sphere fixture with long vacuum gaps in front of and behind the sphere and several stored planes */
+SphereFixture vacuumTestFixture()
+{
+  SphereFixture fixture;
+  fixture.zHalfLength = 3.0;
+  fixture.Nz = 48;
+  fixture.downSampleZ = 4;
+  return fixture;
+}
+
+TEST( vacuum, fftSolver3DSkippingMatchesFullSteps )
+{
+  for ( Splitting_t splitting : {Splitting_t::LIE, Splitting_t::STRANG} )
+  {
+    SphereFixture fixture = vacuumTestFixture();
+    fixture.splitting = splitting;
+    arma::cx_cube planesSkip, planesFull;
+    arma::mat farSkip, farFull;
+    fixture.solve3D( planesSkip, farSkip );
+    fixture.vacuumSkipping = false;
+    fixture.solve3D( planesFull, farFull );
+
+    ASSERT_EQ( planesSkip.n_slices, planesFull.n_slices );
+    ASSERT_EQ( planesSkip.n_slices, fixture.Nz/fixture.downSampleZ+1 );
+    for ( unsigned int i=0;i<planesFull.n_slices;i++ )
+    {
+      double ref = arma::norm( planesFull.slice(i), "fro" );
+      EXPECT_NEAR( arma::norm( planesSkip.slice(i)-planesFull.slice(i), "fro" )/ref, 0.0, 1E-10 );
+    }
+    ASSERT_EQ( farSkip.n_elem, farFull.n_elem );
+    EXPECT_NEAR( arma::norm( farSkip-farFull, "fro" )/arma::norm( farFull, "fro" ), 0.0, 1E-10 );
+  }
+}
+
+TEST( vacuum, fftSolver2DSkippingMatchesFullSteps )
+{
+  for ( Splitting_t splitting : {Splitting_t::LIE, Splitting_t::STRANG} )
+  {
+    SphereFixture fixture = vacuumTestFixture();
+    fixture.splitting = splitting;
+    arma::cx_mat planesSkip, planesFull;
+    arma::vec farSkip, farFull;
+    fixture.solve2D( planesSkip, farSkip );
+    fixture.vacuumSkipping = false;
+    fixture.solve2D( planesFull, farFull );
+
+    ASSERT_EQ( planesSkip.n_cols, planesFull.n_cols );
+    ASSERT_EQ( planesSkip.n_cols, fixture.Nz/fixture.downSampleZ );
+    for ( unsigned int i=0;i<planesFull.n_cols;i++ )
+    {
+      double ref = arma::norm( planesFull.col(i) );
+      EXPECT_NEAR( arma::norm( planesSkip.col(i)-planesFull.col(i) )/ref, 0.0, 1E-10 );
+    }
+    EXPECT_NEAR( arma::norm( farSkip-farFull )/arma::norm( farFull ), 0.0, 1E-10 );
+  }
+}